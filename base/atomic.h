@@ -0,0 +1,80 @@
+/*
+ * SPDX-FileCopyrightText: Copyright © 2005-2023 by Erik Hofman.
+ * SPDX-FileCopyrightText: Copyright © 2009-2023 by Adalin B.V.
+ *
+ * Package Name: AeonWave Audio eXtentions library.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only
+ */
+
+#ifndef _AL_ATOMIC_H
+#define _AL_ATOMIC_H 1
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#if HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+/*
+ * Minimal set of atomic operations used by the object tables.
+ *
+ * Loads have acquire and stores have release semantics, read-modify-write
+ * operations are full barriers. The arithmetic and compare-and-swap macros
+ * operate on unsigned int, the _ptr variants on pointers and the _add64
+ * variant on unsigned long long.
+ */
+#if defined(__GNUC__) || defined(__clang__)
+# define _oal_atomic_load(p)		__atomic_load_n((p), __ATOMIC_ACQUIRE)
+# define _oal_atomic_store(p, v)	__atomic_store_n((p), (v), __ATOMIC_RELEASE)
+# define _oal_atomic_add(p, v)		__atomic_add_fetch((p), (v), __ATOMIC_ACQ_REL)
+# define _oal_atomic_sub(p, v)		__atomic_sub_fetch((p), (v), __ATOMIC_ACQ_REL)
+# define _oal_atomic_add64(p, v)	__atomic_add_fetch((p), (v), __ATOMIC_ACQ_REL)
+# define _oal_atomic_cas(p, o, n)	__atomic_compare_exchange_n((p), (o), (n), 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
+# define _oal_atomic_cas_ptr(p, o, n)	_oal_atomic_cas(p, o, n)
+# define _oal_atomic_exchange_ptr(p, v)	__atomic_exchange_n((p), (v), __ATOMIC_ACQ_REL)
+# define _oal_atomic_fence()		__atomic_thread_fence(__ATOMIC_SEQ_CST)
+
+#elif defined(_MSC_VER)
+# include <Windows.h>
+# include <intrin.h>
+# define _oal_atomic_load(p)		(_ReadWriteBarrier(), *(volatile const __typeof__(*(p))*)(p))
+# define _oal_atomic_store(p, v)	do { _ReadWriteBarrier(); *(volatile __typeof__(*(p))*)(p) = (v); } while(0)
+# define _oal_atomic_add(p, v)		((unsigned int)InterlockedAdd((volatile LONG*)(p), (LONG)(v)))
+# define _oal_atomic_sub(p, v)		((unsigned int)InterlockedAdd((volatile LONG*)(p), -(LONG)(v)))
+# define _oal_atomic_add64(p, v)	((unsigned long long)InterlockedAdd64((volatile LONG64*)(p), (LONG64)(v)))
+# define _oal_atomic_cas(p, o, n)	__oal_atomic_cas((volatile LONG*)(p), (LONG*)(o), (LONG)(n))
+# define _oal_atomic_cas_ptr(p, o, n)	__oal_atomic_cas_ptr((PVOID volatile*)(p), (PVOID*)(o), (PVOID)(n))
+# define _oal_atomic_exchange_ptr(p, v)	InterlockedExchangePointer((PVOID volatile*)(p), (PVOID)(v))
+# define _oal_atomic_fence()		MemoryBarrier()
+
+static __inline int
+__oal_atomic_cas(volatile LONG *p, LONG *o, LONG n)
+{
+    LONG prev = InterlockedCompareExchange(p, n, *o);
+    int rv = (prev == *o);
+    *o = prev;
+    return rv;
+}
+
+static __inline int
+__oal_atomic_cas_ptr(PVOID volatile *p, PVOID *o, PVOID n)
+{
+    PVOID prev = InterlockedCompareExchangePointer(p, n, *o);
+    int rv = (prev == *o);
+    *o = prev;
+    return rv;
+}
+
+#else
+# error "Unsupported compiler: no atomic operations available"
+#endif
+
+#if defined(__cplusplus)
+}  /* extern "C" */
+#endif
+
+#endif /* !_AL_ATOMIC_H */
+
@@ -17,6 +17,8 @@
 #include <stdarg.h>
 
 #include "buffers.h"
+#include "atomic.h"
+#include "epoch.h"
 
 #ifdef NDEBUG
 # include <stdlib.h>
@@ -70,21 +72,67 @@ const char *_alBufNames[] =
 # endif
 #endif
 
-static int __alBufFreeSpace(_alBuffers *, int, char);
+static int __alBufReserve(_alBuffers *, int, unsigned int, char);
+#define __alBufFreeSpace(a, b, c)	__alBufReserve(a, b, 1, c)
+static void __alBufUnlock(_alBufferData *);
+static void __alBufDestroy(void *);
+static _alBufferData *__alBufDataCreate(_alBuffers *, const void *);
+static unsigned int __alBufInsertNoLock(_alBuffers *, _alBufferData *);
+static unsigned int __alBufHandleNextFree(_alBuffers *);
+static void *__alBufRemoveNoLock(_alBuffers *, unsigned int, unsigned int, char, _alBufFreeCallback *);
+static int __alBufMapResize(_alBuffers *, unsigned int);
+static void __alBufMapRebuild(_alBuffers *);
+static void __alBufMapSet(_alBuffers *, unsigned int);
+static void __alBufMapClear(_alBuffers *, unsigned int);
+static unsigned int __alBufMapNextFree(const _alBuffers *, unsigned int);
+static void __alBufIndexCreate(_alBuffers *);
+static void __alBufIndexDestroy(_alBuffers *);
+static void __alBufIndexInsert(_alBuffers *, const void *, unsigned int);
+static void __alBufIndexRemove(_alBuffers *, const void *, unsigned int);
+static unsigned int __alBufIndexFind(const _alBuffers *, const void *);
+
+#if BUFFER_STATS
+# include <stdio.h>
+# include <stdlib.h>
+# include <string.h>
+# if HAVE_STRINGS_H
+#  include <strings.h>
+# endif
+# include "types.h"
+
+static _alBufCounters __alBufCounters[BUFFER_STATS_MAX_ID];
+static int __alBufStatsEnabled = -1;
+static int __alBufStatsInit(void);
+static void __alBufCountPeak(unsigned int, unsigned int);
+
+# define __alBufStatsOn() \
+    ((__alBufStatsEnabled < 0) ? __alBufStatsInit() : __alBufStatsEnabled)
+# define BUFFER_COUNT(id, field, n) do { \
+    if (__alBufStatsOn() && (unsigned int)(id) < BUFFER_STATS_MAX_ID) \
+        _oal_atomic_add64(&__alBufCounters[id].field, (n)); } while(0)
+# define BUFFER_PEAK(id, n)	__alBufCountPeak(id, n)
+#else
+# define BUFFER_COUNT(id, field, n)
+# define BUFFER_PEAK(id, n)
+#endif
+
+#ifndef _AL_NOTHREADS
+static void __alBufLock(_alBuffers *, char *, int);
+#endif
 
 
 #ifdef BUFFER_DEBUG
 unsigned int
-_alBufCreateDebug(_alBuffers **buffer, unsigned int id, DISREGARD(char *file), DISREGARD(int line))
+_alBufCreateDebug(_alBuffers **buffer, unsigned int id, unsigned int mode, DISREGARD(char *file), DISREGARD(int line))
 {
-    unsigned int r = _alBufCreateNormal(buffer, id);
+    unsigned int r = _alBufCreateNormal(buffer, id, mode);
     PRINT("create: %s at line %i: %x\n", file, line, r);
     return r;
 }
 #endif
 
 unsigned int
-_alBufCreateNormal(_alBuffers **buffer, unsigned int id)
+_alBufCreateNormal(_alBuffers **buffer, unsigned int id, unsigned int mode)
 {
     unsigned int rv = UINT_MAX;
 
@@ -98,6 +146,40 @@ _alBufCreateNormal(_alBuffers **buffer, unsigned int id)
         unsigned int num = BUFFER_RESERVE;
 
         (*buffer)->data = calloc(num, sizeof(_alBufferData*));
+        if ((*buffer)->data && (mode & BUFFER_HANDLES))
+        {
+            (*buffer)->generation = calloc(num, sizeof(unsigned int));
+            (*buffer)->recycle = malloc(num*sizeof(unsigned int));
+            if (!(*buffer)->generation || !(*buffer)->recycle)
+            {
+                free((*buffer)->recycle);
+                free((*buffer)->generation);
+                free((*buffer)->data);
+                (*buffer)->data = NULL;
+            }
+        }
+
+        if ((*buffer)->data)
+        {
+            (*buffer)->slab = _alSlabCreate(sizeof(_alBufferData));
+            if (!(*buffer)->slab)
+            {
+                free((*buffer)->recycle);
+                free((*buffer)->generation);
+                free((*buffer)->data);
+                (*buffer)->data = NULL;
+            }
+        }
+
+        if ((*buffer)->data && !__alBufMapResize(*buffer, num))
+        {
+            _alSlabDestroy((*buffer)->slab);
+            free((*buffer)->recycle);
+            free((*buffer)->generation);
+            free((*buffer)->data);
+            (*buffer)->data = NULL;
+        }
+
         if ((*buffer)->data)
         {
 #ifndef _AL_NOTHREADS
@@ -113,7 +195,12 @@ _alBufCreateNormal(_alBuffers **buffer, unsigned int id)
             (*buffer)->first_free = 0;		/* relative to start */
             (*buffer)->num_allocated = 0;	/* relative to start */
             (*buffer)->max_allocations = num;	/* absolute          */
+            (*buffer)->mode = mode;
             (*buffer)->id = id;
+
+            if (mode & BUFFER_PTR_INDEX) {
+                __alBufIndexCreate(*buffer);
+            }
             rv = 0;
         }
         else
@@ -126,6 +213,71 @@ _alBufCreateNormal(_alBuffers **buffer, unsigned int id)
     return rv;
 }
 
+unsigned int
+_alBufPosToHandle(const _alBuffers *buffer, unsigned int id, unsigned int pos)
+{
+    unsigned int rv = 0;
+
+    assert(buffer != 0);
+    assert(buffer->id == id);
+
+    if (pos != UINT_MAX)
+    {
+        if (buffer->mode & BUFFER_HANDLES)
+        {
+            unsigned int gen;
+
+            assert(buffer->start == 0);
+            assert(pos < buffer->max_allocations);
+
+            gen = _oal_atomic_load(&buffer->generation[pos]);
+            rv = (BUFFER_GENERATION(gen) << BUFFER_HANDLE_BITS) | (pos + 1);
+        }
+        else {
+            rv = _alBufPosToId(pos);
+        }
+    }
+
+    return rv;
+}
+
+unsigned int
+_alBufHandleToPos(const _alBuffers *buffer, unsigned int id, unsigned int handle)
+{
+    unsigned int rv = UINT_MAX;
+
+    assert(buffer != 0);
+    assert(buffer->id == id);
+
+    if (!(buffer->mode & BUFFER_HANDLES)) {
+        rv = _alBufIdToPos(handle);
+    }
+    else if (handle & BUFFER_HANDLE_MASK)
+    {
+        unsigned int pos = (handle & BUFFER_HANDLE_MASK) - 1;
+
+        /*
+         * max_allocations is published after the arrays it describes,
+         * so any pair of arrays read after it is at least this large.
+         */
+        if (pos < _oal_atomic_load(&buffer->max_allocations))
+        {
+            unsigned int *generation = _oal_atomic_load(&buffer->generation);
+            _alBufferData **data = _oal_atomic_load(&buffer->data);
+            unsigned int gen = _oal_atomic_load(&generation[pos]);
+
+            if (BUFFER_GENERATION(gen) == (handle >> BUFFER_HANDLE_BITS) &&
+                _oal_atomic_load(&data[pos]) != NULL &&
+                _oal_atomic_load(&generation[pos]) == gen)
+            {
+                rv = pos;
+            }
+        }
+    }
+
+    return rv;
+}
+
 int
 _alBufDestroyDataNoLock(_alBufferData *ptr)
 {
@@ -133,12 +285,8 @@ _alBufDestroyDataNoLock(_alBufferData *ptr)
 
     assert(ptr);
 
-    if ((rv = --ptr->reference_ctr) == 0)
-    {
-#ifndef _AL_NOTHREADS
-        _aaxMutexDestroy(ptr->mutex);
-#endif
-        free(ptr);
+    if ((rv = _oal_atomic_sub(&ptr->reference_ctr, 1)) == 0) {
+        __alBufUnlock(ptr);
     }
 
     if (!rv) rv = UINT_MAX;
@@ -159,52 +307,74 @@ _alBufAddDataNormal(_alBuffers *buffer, unsigned int id, const void *data, char
     assert(buffer->start+buffer->first_free <= buffer->max_allocations);
     assert(buffer->start+buffer->num_allocated <= buffer->max_allocations);
 
-    if (__alBufFreeSpace(buffer, id, locked))
+    _alBufferData *b = __alBufDataCreate(buffer, data);
+    if (b)
     {
-        _alBufferData *b = malloc(sizeof(_alBufferData));
-        if (b)
-        {
-            unsigned int pos;
+        /* reserve and insert under one lock, as _alBufAddDataBatch does */
+        if (!locked) {
+           _alBufGetNum(buffer, id);
+        }
 
-#ifndef _AL_NOTHREADS
-            b->mutex =
-# ifndef NDEBUGTHREADS
-                _aaxMutexCreateDebug(0, _alBufNames[id], __func__);
-# else
-                _aaxMutexCreate(0);
-# endif
-#endif
-            b->reference_ctr = 1;
-            b->ptr = data;
+        if (__alBufFreeSpace(buffer, id, 1)) {
+            rv = __alBufInsertNoLock(buffer, b);
+        }
 
-            if (!locked) {
-               _alBufGetNum(buffer, id);
-            }
+        if (!locked) {
+           _alBufReleaseNum(buffer, id);
+        }
+
+        if (rv == UINT_MAX) {
+            _alSlabFree(b);
+        }
+    }
+
+    return rv;
+}
+
+unsigned int
+_alBufAddDataBatch(_alBuffers *buffer, unsigned int id, const void **data,
+                   unsigned int num, unsigned int *pos)
+{
+    unsigned int i, rv = UINT_MAX;
+    _alBufferData **b;
 
-            rv = buffer->first_free++;
-            pos = buffer->start + rv;
+    assert(data != 0);
+    assert(pos != 0);
+    assert(buffer != 0);
+    assert(buffer->id == id);
+    assert(buffer->data != 0);
 
-//          assert(buffer->data[pos] == NULL);
+    if (!num) return 0;
 
-            buffer->data[pos] = b;
-            buffer->num_allocated++;
+    b = malloc(num*sizeof(_alBufferData*));
+    if (b)
+    {
+        for (i=0; i<num; i++)
+        {
+            assert(data[i] != 0);
+            if ((b[i] = __alBufDataCreate(buffer, data[i])) == NULL) break;
+        }
 
-            assert(pos+1 < buffer->max_allocations);
-            if (buffer->data[++pos] != 0)
+        if (i == num)
+        {
+            _alBufGetNum(buffer, id);
+            if (__alBufReserve(buffer, id, num, 1))
             {
-                unsigned int i, max = buffer->max_allocations - buffer->start;
-                for(i=buffer->first_free; i<max; i++)
-                {
-                    if (buffer->data[buffer->start+i] == 0)
-                        break;
+                for (i=0; i<num; i++) {
+                    pos[i] = __alBufInsertNoLock(buffer, b[i]);
                 }
-                buffer->first_free = i;
+                rv = num;
             }
+            _alBufReleaseNum(buffer, id);
+        }
 
-            if (!locked) {
-               _alBufReleaseNum(buffer, id);
+        if (rv == UINT_MAX)
+        {
+            while (i--) {
+                _alSlabFree(b[i]);
             }
         }
+        free(b);
     }
 
     return rv;
@@ -231,39 +401,17 @@ _alBufAddReference(_alBuffers *buffer, unsigned int id,
 
     assert(data->data[n] != 0);
 
-    if (__alBufFreeSpace(buffer, id, 0))
+    _alBufGetNum(buffer, id);
+    if (__alBufFreeSpace(buffer, id, 1))
     {
         _alBufferData *b = data->data[n];
         if (b)
         {
-            unsigned int i, num;
-
-#ifndef _AL_NOTHREADS
-            _aaxMutexLock(b->mutex);
-#endif
-            b->reference_ctr++;
-#ifndef _AL_NOTHREADS
-            _aaxMutexUnLock(b->mutex);
-#endif
-
-            _alBufGetNum(buffer, id);
-
-            buffer->num_allocated++;
-            buffer->data[buffer->start+buffer->first_free] = b;
-            rv = buffer->first_free;
-
-            num = buffer->max_allocations - buffer->start;
-            for(i=buffer->first_free; i<num; i++)
-            {
-                if (buffer->data[buffer->start+i] == 0)
-                    break;
-            }
-            buffer->first_free = i;
-
-            _alBufReleaseNum(buffer, id);
+            _oal_atomic_add(&b->reference_ctr, 1);
+            rv = __alBufInsertNoLock(buffer, b);
         }
-
     }
+    _alBufReleaseNum(buffer, id);
 
     return rv;
 }
@@ -286,8 +434,14 @@ _alBufReplace(_alBuffers *buffer, unsigned int id, unsigned int n, void *data)
     buf = _alBufGet(buffer, id, n);
     if (buf)
     {
+        /* the pointer index is only changed with the table locked */
+        _alBufGetNum(buffer, id);
         rv = buf->ptr;
-        buf->ptr = data;
+        _oal_atomic_store(&buf->ptr, data);
+        __alBufIndexRemove(buffer, rv, buffer->start+n);
+        __alBufIndexInsert(buffer, data, buffer->start+n);
+        _alBufReleaseNum(buffer, id);
+
         _alBufReleaseData(buf, id);
     }
 
@@ -296,8 +450,10 @@ _alBufReplace(_alBuffers *buffer, unsigned int id, unsigned int n, void *data)
 
 #ifdef BUFFER_DEBUG
 _alBufferData *
-_alBufGetDebug(_alBuffers *buffer, unsigned int id, unsigned int n, char locked, char *file, int line)
+_alBufGetDebug(_alBuffers *buffer, unsigned int id, unsigned int n, char locked, DISREGARD(char *file), DISREGARD(int line))
 {
+    _alBufferData *rv;
+
     if (n == UINT_MAX) return NULL;
 
     assert(buffer != 0);
@@ -308,21 +464,20 @@ _alBufGetDebug(_alBuffers *buffer, unsigned int id, unsigned int n, char locked,
     assert(n < buffer->max_allocations);
     assert(buffer->data != 0);
 
-#ifndef _AL_NOTHREADS
-    if (!locked && buffer->data[n] != 0)
-    {
-        int r = _aaxMutexLockDebug(buffer->data[n]->mutex, file, line);
-        if (r < 0) { PRINT("error: %i at %s line %i\n", -r, file, line); }
+    rv = _alBufGetNormal(buffer, id, n - buffer->start, locked);
+    if (!locked && rv) {
+        PRINT("get: %s at line %i: %i references\n", file, line, rv->lock_ctr);
     }
-#endif
 
-    return buffer->data[n];
+    return rv;
 }
 #endif
 
 _alBufferData *
 _alBufGetNormal(_alBuffers *buffer, unsigned int id, unsigned int n, char locked)
 {
+    _alBufferData *rv;
+
     if (n == UINT_MAX) return NULL;
 
     assert(buffer);
@@ -330,19 +485,39 @@ _alBufGetNormal(_alBuffers *buffer, unsigned int id, unsigned int n, char locked
 
     n += buffer->start;
 
-#ifndef _AL_NOTHREADS
-    if (!locked && buffer->data[n] != NULL) {
-        _aaxMutexLock(buffer->data[n]->mutex);
-    }
-#endif
-
     assert(n < buffer->max_allocations);
     assert(buffer->data != 0);
 
-    return buffer->data[n];
+    BUFFER_COUNT(id, lookups, 1);
+    if (!locked)
+    {
+        _alEpochEnter();
+        rv = _oal_atomic_load(&_oal_atomic_load(&buffer->data)[n]);
+        rv = _alBufAcquireData(rv, id);
+        _alEpochLeave();
+    }
+    else {
+        rv = _oal_atomic_load(&_oal_atomic_load(&buffer->data)[n]);
+    }
+
+    return rv;
+}
+
+_alBufferData *
+_alBufAcquireData(_alBufferData *data, DISREGARD(unsigned int id))
+{
+    if (data)
+    {
+        /* never revive an object which is already on it's way out */
+        unsigned int ctr = _oal_atomic_load(&data->lock_ctr);
+        while (ctr && !_oal_atomic_cas(&data->lock_ctr, &ctr, ctr+1)) {
+            BUFFER_COUNT(id, retries, 1);
+        }
+        if (!ctr) data = NULL;
+    }
+    return data;
 }
 
-#ifndef _AL_NOTHREADS
 void
 _alBufRelease(_alBuffers *buffer, unsigned int id, unsigned int n)
 {
@@ -356,9 +531,8 @@ _alBufRelease(_alBuffers *buffer, unsigned int id, unsigned int n)
     assert(buffer->data[n] != 0);
     assert(buffer->data[n]->ptr != 0);
 
-    _aaxMutexUnLock(buffer->data[n]->mutex);
+    __alBufUnlock(buffer->data[n]);
 }
-#endif
 
 void *
 _alBufGetDataPtr(const _alBufferData *data)
@@ -382,23 +556,26 @@ _alBufSetDataPtr(_alBufferData *data, void *user_data)
     return ret;
 }
 
-#ifndef _AL_NOTHREADS
-# ifndef NDEBUGTHREADS
+#ifndef NDEBUG
 void
-_alBufReleaseDataDebug(const _alBufferData *data, DISREGARD(unsigned int id), char *file, int line)
+_alBufReleaseDataDebug(const _alBufferData *data, DISREGARD(unsigned int id), DISREGARD(char *file), DISREGARD(int line))
 {
-    assert(data != 0);
-
-    _aaxMutexUnLockDebug(data->mutex, file, line);
+    if (data)
+    {
+        assert(data->lock_ctr > 0);
+        PRINT("release: %s at line %i: %i references\n", file, line, data->lock_ctr);
+        __alBufUnlock((_alBufferData *)data);
+    }
 }
-# endif
+#endif
 
 void
 _alBufReleaseDataNormal(const _alBufferData *data, DISREGARD(unsigned int id))
 {
-    _aaxMutexUnLock(data->mutex);
+    if (data) {
+        __alBufUnlock((_alBufferData *)data);
+    }
 }
-#endif
 
 unsigned int
 _alBufGetNumNoLock(const _alBuffers *buffer, unsigned int id)
@@ -417,8 +594,9 @@ _alBufGetNumDebug(_alBuffers *buffer, DISREGARD(unsigned int id), DISREGARD(char
     assert(buffer->id == id);
 
 #ifndef _AL_NOTHREADS
-    _aaxMutexLockDebug(buffer->mutex, file, line);
+    __alBufLock(buffer, file, line);
 #endif
+    BUFFER_COUNT(id, locks, 1);
 
     return buffer->num_allocated;
 
@@ -429,12 +607,28 @@ unsigned int
 _alBufGetNumNormal(_alBuffers *buffer, DISREGARD(unsigned int id), DISREGARD(char lock))
 {
 #ifndef _AL_NOTHREADS
-    _aaxMutexLock(buffer->mutex);
+    __alBufLock(buffer, NULL, 0);
 #endif
+    BUFFER_COUNT(id, locks, 1);
 
     return buffer->num_allocated;
 }
 
+int
+_alBufReserve(_alBuffers *buffer, unsigned int id, unsigned int num)
+{
+    int rv;
+
+    assert(buffer != 0);
+    assert(buffer->id == id);
+
+    _alBufGetNum(buffer, id);
+    rv = __alBufReserve(buffer, id, num, 1);
+    _alBufReleaseNum(buffer, id);
+
+    return rv;
+}
+
 unsigned int
 _alBufGetMaxNumNoLock(const _alBuffers *buffer, DISREGARD(unsigned int id))
 {
@@ -444,6 +638,90 @@ _alBufGetMaxNumNoLock(const _alBuffers *buffer, DISREGARD(unsigned int id))
     return buffer->max_allocations;
 }
 
+void
+_alBufGetStats(const _alBuffers *buffer, DISREGARD(unsigned int id), _alSlabStats *stats)
+{
+    assert(buffer != 0);
+    assert(buffer->id == id);
+
+    _alSlabGetStats(buffer->slab, stats);
+}
+
+int
+_alBufGetCounters(unsigned int id, _alBufCounters *counters)
+{
+    int rv = 0;
+
+    assert(counters);
+
+    memset(counters, 0, sizeof(_alBufCounters));
+#if BUFFER_STATS
+    rv = __alBufStatsOn();
+    if (rv && id < BUFFER_STATS_MAX_ID)
+    {
+        _alBufCounters *c = &__alBufCounters[id];
+
+        counters->lookups = _oal_atomic_load(&c->lookups);
+        counters->retries = _oal_atomic_load(&c->retries);
+        counters->locks = _oal_atomic_load(&c->locks);
+        counters->contended = _oal_atomic_load(&c->contended);
+        counters->wait_ns = _oal_atomic_load(&c->wait_ns);
+        counters->grows = _oal_atomic_load(&c->grows);
+        counters->moves = _oal_atomic_load(&c->moves);
+        counters->peak = _oal_atomic_load(&c->peak);
+    }
+#else
+    (void)id;
+#endif
+
+    return rv;
+}
+
+void
+_alBufResetCounters()
+{
+#if BUFFER_STATS
+    memset(__alBufCounters, 0, sizeof(__alBufCounters));
+#endif
+}
+
+void
+_alBufDumpCounters(const char *names[], unsigned int num)
+{
+#if BUFFER_STATS
+    unsigned int id;
+
+    if (!__alBufStatsOn()) return;
+
+    fprintf(stderr, "%-12s %10s %8s %10s %8s %10s %6s %6s %8s\n", "table",
+                    "lookups", "retries", "locks", "contend", "wait(us)",
+                    "grows", "moves", "peak");
+    for (id=1; id<BUFFER_STATS_MAX_ID; id++)
+    {
+        _alBufCounters c;
+
+        _alBufGetCounters(id, &c);
+        if (c.lookups || c.locks || c.peak)
+        {
+            char name[16];
+
+            if (names && id < num) {
+                snprintf(name, sizeof(name), "%s", names[id]);
+            } else {
+                snprintf(name, sizeof(name), "id %u", id);
+            }
+
+            fprintf(stderr, "%-12s %10llu %8llu %10llu %8llu %10llu %6llu %6llu %8u\n",
+                    name, c.lookups, c.retries, c.locks, c.contended,
+                    c.wait_ns/1000, c.grows, c.moves, c.peak);
+        }
+    }
+#else
+    (void)names;
+    (void)num;
+#endif
+}
+
 unsigned int
 _alBufGetMaxNumNormal(_alBuffers *buffer, DISREGARD(unsigned int id), DISREGARD(char lock))
 {
@@ -451,8 +729,9 @@ _alBufGetMaxNumNormal(_alBuffers *buffer, DISREGARD(unsigned int id), DISREGARD(
     assert(buffer->id == id);
 
 #ifndef _AL_NOTHREADS
-    _aaxMutexLock(buffer->mutex);
+    __alBufLock(buffer, NULL, 0);
 #endif
+    BUFFER_COUNT(id, locks, 1);
 
     return buffer->max_allocations;
 }
@@ -479,18 +758,27 @@ _alBufGetPos(_alBuffers *buffer, unsigned int id, void *data)
     assert(buffer != 0);
     assert(buffer->id == id);
 
+    BUFFER_COUNT(id, lookups, 1);
     _alBufGetNum(buffer, id);
 
     start = buffer->start;
-    num = buffer->num_allocated;
-    max = buffer->max_allocations - start;
-    for (i=0; i<max; i++)
+    if (buffer->index)
     {
-        if (buffer->data[start+i] && buffer->data[start+i]->ptr == data) break;
-        if (--num == 0) break;
+        i = __alBufIndexFind(buffer, data);
+        if (i != UINT_MAX) i -= start;
     }
-    if (!num || (i == max)) {
-        i = UINT_MAX;
+    else
+    {
+        num = buffer->num_allocated;
+        max = buffer->max_allocations - start;
+        for (i=0; i<max; i++)
+        {
+            if (buffer->data[start+i] && buffer->data[start+i]->ptr == data) break;
+            if (--num == 0) break;
+        }
+        if (!num || (i == max)) {
+            i = UINT_MAX;
+        }
     }
 
     _alBufReleaseNum(buffer, id);
@@ -545,6 +833,7 @@ _alBufPopNormal(_alBuffers *buffer, unsigned int id, char locked)
 
     assert(buffer != 0);
     assert(buffer->id == id);
+    assert(!(buffer->mode & BUFFER_PTR_INDEX));
 
     if (!locked) {
         _alBufGetNum(buffer, id);
@@ -555,7 +844,8 @@ _alBufPopNormal(_alBuffers *buffer, unsigned int id, char locked)
         unsigned int start = buffer->start;
 
         rv = _alBufGet(buffer, id, 0);
-        buffer->data[start] = NULL;
+        _oal_atomic_store(&buffer->data[start], NULL);
+        __alBufMapClear(buffer, start);
         _alBufReleaseData(rv, id);
 
         /*
@@ -584,42 +874,42 @@ _alBufPopNormal(_alBuffers *buffer, unsigned int id, char locked)
     return rv;
 }
 
-void
+int
 _alBufPushNormal(_alBuffers *buffer, unsigned int id, const _alBufferData *data, char locked)
 {
+    int rv = 0;
+
     assert(buffer != 0);
     assert(buffer->id == id);
+    assert(!(buffer->mode & BUFFER_PTR_INDEX));
+
+    if (!locked) {
+        _alBufGetNum(buffer, id);
+    }
 
-    if (__alBufFreeSpace(buffer, id, locked))
+    if (__alBufFreeSpace(buffer, id, 1))
     {
         unsigned int pos; 
 
-        if (!locked) {
-            _alBufGetNum(buffer, id);
-        }
-
         pos = buffer->start + buffer->first_free++;
 
         assert(buffer->data[pos] == NULL);
 
-        buffer->data[pos] = (_alBufferData *)data;
+        _oal_atomic_store(&buffer->data[pos], (_alBufferData *)data);
         buffer->num_allocated++;
+        BUFFER_PEAK(id, buffer->num_allocated);
+        __alBufMapSet(buffer, pos);
 
-        if (buffer->data[++pos] != 0)
-        {
-            unsigned int i, max = buffer->max_allocations - buffer->start;
-            for(i=buffer->first_free; i<max; i++)
-            {
-                if (buffer->data[buffer->start+i] == 0)
-                    break;
-            }
-            buffer->first_free = i;
-        }
+        buffer->first_free = __alBufMapNextFree(buffer, pos+1);
+        buffer->first_free -= buffer->start;
+        rv = -1;
+    }
 
-        if (!locked) {
-            _alBufReleaseNum(buffer, id);
-        }
+    if (!locked) {
+        _alBufReleaseNum(buffer, id);
     }
+
+    return rv;
 }
 
 #ifdef BUFFER_DEBUG
@@ -632,8 +922,7 @@ _alBufRemoveDebug(_alBuffers *buffer, unsigned int id, unsigned int n,
     PRINT("remove: %s at line %i: %x\n", file, lineno, n);
     return r;
 #else
-   _alBufferData *buf;
-    void *rv = 0;
+    void *rv;
 
     assert(buffer != 0);
     assert(buffer->id == id);
@@ -645,38 +934,11 @@ _alBufRemoveDebug(_alBuffers *buffer, unsigned int id, unsigned int n,
     }
     _alBufGetNumDebug(buffer, id, 1, file, lineno);
 
-    buf = _alBufGetDebug(buffer, id, n, locked, file, lineno);
-    if (buf)
-    {
-        assert(buf->reference_ctr > 0);
+    rv = __alBufRemoveNoLock(buffer, id, n, locked, NULL);
+    PRINT("remove: %s at line %i: %x\n", file, lineno, n);
 
-        /*
-         * If the counter doesn't equal to zero this buffer was referenced
-         * by another buffer. So just detach it and let the last referer
-         * take care of it.
-         */
-        if (--buf->reference_ctr == 0)
-        {
 # ifndef _AL_NOTHREADS
-            _aaxMutexDestroy(buf->mutex);
-# endif
-            rv = (void*)buf->ptr;
-            free(buf);
-            buf = 0;
-        }
-        else {
-            _alBufReleaseData(buf, id);
-        }
-
-        buffer->data[buffer->start+n] = NULL;
-        buffer->num_allocated--;
-        if (buffer->first_free > n) {
-            buffer->first_free = n;
-        }
-    }
-
-# ifndef _AL_NOTHREADS
-    _alBufReleaseNumNormal(buffer, id, 1);
+    _alBufReleaseNumNormal(buffer, id, 1);
 # endif
     if (num_locked) {
         _alBufGetNum(buffer, id);
@@ -691,8 +953,7 @@ void *
 _alBufRemoveNormal(_alBuffers *buffer, unsigned int id, unsigned int n,
                                          char locked, char num_locked)
 {
-    _alBufferData *buf;
-    void *rv = 0;
+    void *rv;
 
     assert(buffer != 0);
     assert(buffer->id == id);
@@ -704,35 +965,7 @@ _alBufRemoveNormal(_alBuffers *buffer, unsigned int id, unsigned int n,
     }
     _alBufGetNumNormal(buffer, id, 1);
 
-    buf = _alBufGetNormal(buffer, id, n, locked);
-    if (buf)
-    {
-        assert(buf->reference_ctr > 0);
-
-        /*
-         * If the counter doesn't equal to zero this buffer was referenced
-         * by another buffer. So just detach it and let the last referer
-         * take care of it.
-         */
-        if (--buf->reference_ctr == 0)
-        {
-#ifndef _AL_NOTHREADS
-            _aaxMutexDestroy(buf->mutex);
-#endif
-            rv = (void*)buf->ptr;
-            free(buf);
-            buf = 0;
-        }
-        else {
-            _alBufReleaseData(buf, id);
-        }
-
-        buffer->data[buffer->start+n] = NULL;
-        buffer->num_allocated--;
-        if (buffer->first_free > n) {
-            buffer->first_free = n;
-        }
-    }
+    rv = __alBufRemoveNoLock(buffer, id, n, locked, NULL);
 
 #ifndef _AL_NOTHREADS
     _alBufReleaseNumNormal(buffer, id, 1);
@@ -744,6 +977,61 @@ _alBufRemoveNormal(_alBuffers *buffer, unsigned int id, unsigned int n,
     return rv;
 }
 
+int
+_alBufRemoveRelease(_alBuffers *buffer, unsigned int id, unsigned int n,
+                    _alBufFreeCallback *cb_free)
+{
+    int rv = 0;
+
+    assert(cb_free != 0);
+    assert(buffer != 0);
+    assert(buffer->id == id);
+    assert(buffer->start+n < buffer->max_allocations);
+    assert(buffer->data != 0);
+
+    _alBufGetNumNormal(buffer, id, 1);
+    if (_oal_atomic_load(&buffer->data[buffer->start+n]))
+    {
+        __alBufRemoveNoLock(buffer, id, n, 0, cb_free);
+        rv = -1;
+    }
+    _alBufReleaseNum(buffer, id);
+
+    return rv;
+}
+
+unsigned int
+_alBufRemoveBatch(_alBuffers *buffer, unsigned int id,
+                  const unsigned int *pos, unsigned int num, void **data)
+{
+    unsigned int i, rv = 0;
+
+    assert(pos != 0);
+    assert(buffer != 0);
+    assert(buffer->id == id);
+    assert(buffer->data != 0);
+
+    _alBufGetNumNormal(buffer, id, 1);
+    for (i=0; i<num; i++)
+    {
+        void *ptr = NULL;
+
+        if (pos[i] != UINT_MAX)
+        {
+            assert(buffer->start+pos[i] < buffer->max_allocations);
+            if (_oal_atomic_load(&buffer->data[buffer->start+pos[i]]))
+            {
+                ptr = __alBufRemoveNoLock(buffer, id, pos[i], 0, NULL);
+                rv++;
+            }
+        }
+        if (data) data[i] = ptr;
+    }
+    _alBufReleaseNum(buffer, id);
+
+    return rv;
+}
+
 
 #ifdef BUFFER_DEBUG
 void 
@@ -772,8 +1060,9 @@ _alBufClearNormal(_alBuffers *buffer, unsigned int id,
     max = buffer->max_allocations - start;
     for (n=0; n<max; n++)
     {
-        void *rv = _alBufRemoveNormal(buffer, id, n, 0, 1);
-        if (rv && cb_free) cb_free(rv);
+        if (_oal_atomic_load(&buffer->data[start+n])) {
+            __alBufRemoveNoLock(buffer, id, n, 0, cb_free);
+        }
     }
     buffer->start = 0;
 
@@ -831,74 +1120,628 @@ _alBufEraseNormal(_alBuffers **buf, unsigned int id,
             while (--max);
         }
 #endif
-        free(buffer->data);
+
+        /*
+         * Lock-free readers might still be using the arrays of the table,
+         * unpublish it first and free it once they are done.
+         */
+        _oal_atomic_store(buf, NULL);
+        _alEpochRetire(buffer, __alBufDestroy);
+        _alEpochSynchronize();
+    }
+}
+
+static void
+__alBufDestroy(void *ptr)
+{
+    _alBuffers *buffer = (_alBuffers*)ptr;
+
+    __alBufIndexDestroy(buffer);
+    free(buffer->recycle);
+    free(buffer->generation);
+    free(buffer->occupied);
+    free(buffer->data);
+    _alSlabDestroy(buffer->slab);
 
 #ifndef _AL_NOTHREADS
-        _aaxMutexDestroy(buffer->mutex);
+    _aaxMutexDestroy(buffer->mutex);
 #endif
-        free(buffer);
-        *buf = 0;
-    }
+    free(buffer);
 }
 
 /* -------------------------------------------------------------------------- */
 
+/*
+ * Bitmap of used positions, the first free position after any position
+ * is found by scanning it a word at a time using count-trailing-zeros.
+ */
+#define BUFFER_MAP_BITS		(8*sizeof(unsigned int))
+#define BUFFER_MAP_SIZE(a)	(((a)+BUFFER_MAP_BITS-1)/BUFFER_MAP_BITS)
+
+#if defined(__GNUC__) || defined(__clang__)
+# define BUFFER_CTZ(a)		__builtin_ctz(a)
+#elif defined(_MSC_VER)
+# include <intrin.h>
+static __inline unsigned int
+BUFFER_CTZ(unsigned int a)
+{
+    unsigned long rv;
+    _BitScanForward(&rv, a);
+    return rv;
+}
+#else
+static unsigned int
+BUFFER_CTZ(unsigned int a)
+{
+    unsigned int rv = 0;
+    while (!(a & 1)) { a >>= 1; rv++; }
+    return rv;
+}
+#endif
+
+static int
+__alBufMapResize(_alBuffers *buffer, unsigned int max)
+{
+    unsigned int size = BUFFER_MAP_SIZE(buffer->max_allocations);
+    unsigned int new_size = BUFFER_MAP_SIZE(max);
+    unsigned int *map = buffer->occupied;
+    int rv = -1;
+
+    if (!map || new_size > size)
+    {
+        if (!map) size = 0;
+
+        map = realloc(map, new_size*sizeof(unsigned int));
+        if (map)
+        {
+            memset(map+size, 0, (new_size-size)*sizeof(unsigned int));
+            buffer->occupied = map;
+        }
+        else {
+            rv = 0;
+        }
+    }
+
+    return rv;
+}
+
+static void
+__alBufMapRebuild(_alBuffers *buffer)
+{
+    unsigned int i, max = buffer->max_allocations;
+
+    memset(buffer->occupied, 0, BUFFER_MAP_SIZE(max)*sizeof(unsigned int));
+    for (i=0; i<max; i++)
+    {
+        if (buffer->data[i]) {
+            __alBufMapSet(buffer, i);
+        }
+    }
+}
+
+static void
+__alBufMapSet(_alBuffers *buffer, unsigned int pos)
+{
+    buffer->occupied[pos/BUFFER_MAP_BITS] |= (1u << (pos % BUFFER_MAP_BITS));
+}
+
+static void
+__alBufMapClear(_alBuffers *buffer, unsigned int pos)
+{
+    buffer->occupied[pos/BUFFER_MAP_BITS] &= ~(1u << (pos % BUFFER_MAP_BITS));
+}
+
+/* returns max_allocations if there is no free position at or after pos */
+static unsigned int
+__alBufMapNextFree(const _alBuffers *buffer, unsigned int pos)
+{
+    unsigned int max = buffer->max_allocations;
+    unsigned int rv = max;
+
+    if (pos < max)
+    {
+        unsigned int size = BUFFER_MAP_SIZE(max);
+        unsigned int i = pos/BUFFER_MAP_BITS;
+        unsigned int free_bits;
+
+        free_bits = ~buffer->occupied[i] & (~0u << (pos % BUFFER_MAP_BITS));
+        while (!free_bits && ++i < size) {
+            free_bits = ~buffer->occupied[i];
+        }
+
+        if (free_bits)
+        {
+            rv = i*BUFFER_MAP_BITS + BUFFER_CTZ(free_bits);
+            if (rv > max) rv = max;
+        }
+    }
+
+    return rv;
+}
+
+/*
+ * Open addressing hash table with linear probing which maps user data
+ * pointers to absolute positions. Removed entries are marked and cleaned
+ * up the next time the table gets rehashed. If memory runs out the index
+ * is dropped and _alBufGetPos falls back to a linear search.
+ */
+#define BUFFER_INDEX_MIN	64
+
+typedef struct
+{
+    const void *ptr;
+    unsigned int pos;
+} _alBufIndexEntry;
+
+typedef struct
+{
+    unsigned int size;			/* always a power of two	*/
+    unsigned int used;			/* including removed entries	*/
+    unsigned int num;
+    _alBufIndexEntry *entry;
+} _alBufIndex;
+
+static const char __alBufIndexRemoved = 0;
+#define BUFFER_INDEX_REMOVED	((const void*)&__alBufIndexRemoved)
+
+static unsigned int
+__alBufIndexHash(const void *ptr, unsigned int size)
+{
+    size_t v = (size_t)ptr >> 4;
+
+    v *= 2654435761u;
+    return (unsigned int)(v ^ (v >> 16)) & (size-1);
+}
+
+static int
+__alBufIndexResize(_alBufIndex *index, unsigned int size)
+{
+    _alBufIndexEntry *entry;
+    int rv = 0;
+
+    entry = calloc(size, sizeof(_alBufIndexEntry));
+    if (entry)
+    {
+        unsigned int i;
+
+        for (i=0; i<index->size; i++)
+        {
+            const void *ptr = index->entry[i].ptr;
+            if (ptr && ptr != BUFFER_INDEX_REMOVED)
+            {
+                unsigned int h = __alBufIndexHash(ptr, size);
+                while (entry[h].ptr) {
+                    h = (h+1) & (size-1);
+                }
+                entry[h] = index->entry[i];
+            }
+        }
+
+        free(index->entry);
+        index->entry = entry;
+        index->size = size;
+        index->used = index->num;
+        rv = -1;
+    }
+
+    return rv;
+}
+
+static void
+__alBufIndexCreate(_alBuffers *buffer)
+{
+    _alBufIndex *index = calloc(1, sizeof(_alBufIndex));
+    if (index && __alBufIndexResize(index, BUFFER_INDEX_MIN)) {
+        buffer->index = index;
+    }
+    else
+    {
+        free(index);
+        buffer->mode &= ~BUFFER_PTR_INDEX;
+    }
+}
+
+static void
+__alBufIndexDestroy(_alBuffers *buffer)
+{
+    _alBufIndex *index = buffer->index;
+    if (index)
+    {
+        free(index->entry);
+        free(index);
+        buffer->index = NULL;
+    }
+}
+
+static void
+__alBufIndexInsert(_alBuffers *buffer, const void *ptr, unsigned int pos)
+{
+    _alBufIndex *index = buffer->index;
+    if (index && ptr)
+    {
+        unsigned int h;
+
+        if (2*(index->used+1) > index->size)
+        {
+            unsigned int size = index->size;
+            while (2*(index->num+1) > size/2) {
+                size *= 2;
+            }
+            if (!__alBufIndexResize(index, size))
+            {
+                __alBufIndexDestroy(buffer);
+                buffer->mode &= ~BUFFER_PTR_INDEX;
+                return;
+            }
+        }
+
+        h = __alBufIndexHash(ptr, index->size);
+        while (index->entry[h].ptr && index->entry[h].ptr != BUFFER_INDEX_REMOVED) {
+            h = (h+1) & (index->size-1);
+        }
+        if (!index->entry[h].ptr) {
+            index->used++;
+        }
+        index->entry[h].ptr = ptr;
+        index->entry[h].pos = pos;
+        index->num++;
+    }
+}
+
+static void
+__alBufIndexRemove(_alBuffers *buffer, const void *ptr, unsigned int pos)
+{
+    _alBufIndex *index = buffer->index;
+    if (index && ptr)
+    {
+        unsigned int h = __alBufIndexHash(ptr, index->size);
+        while (index->entry[h].ptr)
+        {
+            if (index->entry[h].ptr == ptr && index->entry[h].pos == pos)
+            {
+                index->entry[h].ptr = BUFFER_INDEX_REMOVED;
+                index->num--;
+                break;
+            }
+            h = (h+1) & (index->size-1);
+        }
+    }
+}
+
+static unsigned int
+__alBufIndexFind(const _alBuffers *buffer, const void *ptr)
+{
+    const _alBufIndex *index = buffer->index;
+    unsigned int rv = UINT_MAX;
+
+    if (index && ptr)
+    {
+        unsigned int h = __alBufIndexHash(ptr, index->size);
+        while (index->entry[h].ptr)
+        {
+            if (index->entry[h].ptr == ptr)
+            {
+                rv = index->entry[h].pos;
+                break;
+            }
+            h = (h+1) & (index->size-1);
+        }
+    }
+
+    return rv;
+}
+
+static _alBufferData *
+__alBufDataCreate(_alBuffers *buffer, const void *data)
+{
+    _alBufferData *b = _alSlabAlloc(buffer->slab);
+    if (b)
+    {
+        b->reference_ctr = 1;
+        b->lock_ctr = 1;
+        b->ptr = data;
+        b->cb_free = NULL;
+    }
+    return b;
+}
+
+/*
+ * Store an object at the first free position, the caller has to make sure
+ * there is room for it and that the buffer is locked.
+ */
+static unsigned int
+__alBufInsertNoLock(_alBuffers *buffer, _alBufferData *b)
+{
+    unsigned int rv, pos;
+
+    if (buffer->mode & BUFFER_HANDLES) {
+        rv = pos = __alBufHandleNextFree(buffer);
+    }
+    else
+    {
+        rv = buffer->first_free;
+        pos = buffer->start + rv;
+        assert(pos+1 < buffer->max_allocations);
+    }
+
+    assert(buffer->data[pos] == NULL);
+
+    _oal_atomic_store(&buffer->data[pos], b);
+    buffer->num_allocated++;
+    BUFFER_PEAK(buffer->id, buffer->num_allocated);
+    __alBufMapSet(buffer, pos);
+    __alBufIndexInsert(buffer, b->ptr, pos);
+
+    if (!(buffer->mode & BUFFER_HANDLES))
+    {
+        buffer->first_free = __alBufMapNextFree(buffer, pos+1);
+        buffer->first_free -= buffer->start;
+    }
+
+    return rv;
+}
+
+/*
+ * The slot for a new object of a handle table: a slot which was never
+ * used, or the slot which was removed longest ago once enough of them are
+ * waiting. The caller has to make sure there is room for it.
+ */
+static unsigned int
+__alBufHandleNextFree(_alBuffers *buffer)
+{
+    unsigned int rv;
+
+    if (buffer->recycle_num > BUFFER_HANDLE_RECYCLE ||
+        buffer->unused == buffer->max_allocations)
+    {
+        assert(buffer->recycle_num > 0);
+
+        rv = buffer->recycle[buffer->recycle_start];
+        if (++buffer->recycle_start == buffer->max_allocations) {
+            buffer->recycle_start = 0;
+        }
+        buffer->recycle_num--;
+    }
+    else {
+        rv = buffer->unused++;
+    }
+
+    return rv;
+}
+
+/*
+ * Without a callback the user data is returned to the caller once no other
+ * array refers to the object. With a callback it is freed on the release
+ * of the last _alBufGet reference instead and NULL is returned.
+ */
+static void *
+__alBufRemoveNoLock(_alBuffers *buffer, unsigned int id, unsigned int n,
+                    char locked, _alBufFreeCallback *cb_free)
+{
+    _alBufferData *buf;
+    void *rv = NULL;
+
+    buf = _alBufGetNormal(buffer, id, n, locked);
+    if (buf)
+    {
+        assert(buf->reference_ctr > 0);
+
+        __alBufIndexRemove(buffer, buf->ptr, buffer->start+n);
+        _oal_atomic_store(&buffer->data[buffer->start+n], NULL);
+        __alBufMapClear(buffer, buffer->start+n);
+        if (buffer->mode & BUFFER_HANDLES)
+        {
+            unsigned int last;
+
+            _oal_atomic_add(&buffer->generation[n], 1);
+
+            last = buffer->recycle_start + buffer->recycle_num++;
+            if (last >= buffer->max_allocations) {
+                last -= buffer->max_allocations;
+            }
+            buffer->recycle[last] = n;
+        }
+
+        /*
+         * If the counter doesn't equal to zero this buffer was referenced
+         * by another buffer. So just detach it and let the last referer
+         * take care of it. The object itself is freed when the last
+         * outstanding _alBufGet reference is released.
+         */
+        if (_oal_atomic_sub(&buf->reference_ctr, 1) == 0)
+        {
+            if (cb_free) buf->cb_free = cb_free;
+            else rv = (void*)buf->ptr;
+            __alBufUnlock(buf);
+        }
+        _alBufReleaseData(buf, id);
+
+        buffer->num_allocated--;
+        if (buffer->first_free > n) {
+            buffer->first_free = n;
+        }
+    }
+
+    return rv;
+}
+
+/*
+ * Drop one reference from lock_ctr and free the object, and it's user data
+ * if requested, when it was the last one.
+ */
+static void
+__alBufUnlock(_alBufferData *data)
+{
+    if (_oal_atomic_sub(&data->lock_ctr, 1) == 0)
+    {
+        if (data->cb_free) data->cb_free((void*)data->ptr);
+        _alEpochRetire(data, _alSlabFree);
+    }
+}
+
 #define BUFFER_INCREMENT(a)	((((a)/BUFFER_RESERVE)+1)*BUFFER_RESERVE)
 
+/*
+ * Handle tables double in size and publish the new arrays atomically,
+ * the old arrays are freed once no lock-free reader can see them anymore.
+ */
 static int
-__alBufFreeSpace(_alBuffers *buffer, int id, char locked)
+__alBufGrowHandles(_alBuffers *buffer)
 {
-    unsigned int start, num, max;
+    unsigned int max, size = buffer->max_allocations;
+    _alBufferData **data;
+    unsigned int *generation, *recycle;
     int rv = 0;
 
+    if (size > BUFFER_HANDLE_MAX/2) {
+        max = BUFFER_HANDLE_MAX;
+    } else {
+        max = 2*size;
+    }
+
+    if (max > size && __alBufMapResize(buffer, max))
+    {
+        data = calloc(max, sizeof(_alBufferData*));
+        generation = calloc(max, sizeof(unsigned int));
+        recycle = malloc(max*sizeof(unsigned int));
+        if (data && generation && recycle)
+        {
+            _alBufferData **old_data = buffer->data;
+            unsigned int *old_generation = buffer->generation;
+            unsigned int num = buffer->recycle_num;
+            unsigned int first = size - buffer->recycle_start;
+
+            if (first > num) first = num;
+            memcpy(data, old_data, size*sizeof(_alBufferData*));
+            memcpy(generation, old_generation, size*sizeof(unsigned int));
+
+            /* the recycle FIFO is only used with the table locked */
+            memcpy(recycle, buffer->recycle+buffer->recycle_start,
+                   first*sizeof(unsigned int));
+            memcpy(recycle+first, buffer->recycle,
+                   (num-first)*sizeof(unsigned int));
+            free(buffer->recycle);
+            buffer->recycle = recycle;
+            buffer->recycle_start = 0;
+
+            /* publish the new arrays before the old ones can be freed */
+            _oal_atomic_store(&buffer->data, data);
+            _oal_atomic_store(&buffer->generation, generation);
+            _oal_atomic_store(&buffer->max_allocations, max);
+
+            _alEpochRetire(old_data, free);
+            _alEpochRetire(old_generation, free);
+            rv = -1;
+        }
+        else
+        {
+            free(recycle);
+            free(generation);
+            free(data);
+        }
+    }
+
+    return rv;
+}
+
+/*
+ * The number of objects a handle table can take without growing, not
+ * counting removed slots which may not be reused yet.
+ */
+static unsigned int
+__alBufHandlesFree(const _alBuffers *buffer)
+{
+    unsigned int rv = buffer->max_allocations - buffer->unused;
+
+    if (buffer->recycle_num > BUFFER_HANDLE_RECYCLE) {
+        rv += buffer->recycle_num - BUFFER_HANDLE_RECYCLE;
+    }
+
+    return rv;
+}
+
+/*
+ * Make sure there is room for at least 'num' new objects. One position is
+ * always kept free at the end of the array.
+ */
+static int
+__alBufReserve(_alBuffers *buffer, int id, unsigned int num, char locked)
+{
+    unsigned int start, max;
+    int rv = -1;
+
     if (!locked) {
         _alBufGetNum(buffer, id);
     }
-    
-    start = buffer->start;
-    num = buffer->num_allocated;
-    max = buffer->max_allocations;
 
-    assert((start+num) <= max);
-    if (((start+num+1) == max) || ((start+buffer->first_free+1) == max))
+    assert((buffer->start+buffer->num_allocated) <= buffer->max_allocations);
+    if (buffer->mode & BUFFER_HANDLES)
+    {
+        assert(buffer->start == 0);
+        while (rv && __alBufHandlesFree(buffer) < num)
+        {
+            rv = __alBufGrowHandles(buffer);
+            if (rv) BUFFER_COUNT(id, grows, 1);
+        }
+
+        /* the table is at it's maximum size, reuse removed slots sooner */
+        if (!rv && buffer->max_allocations - buffer->num_allocated >= num) {
+            rv = -1;
+        }
+    }
+    else while (rv && (buffer->max_allocations - buffer->start
+                       - buffer->num_allocated) < num+1)
     {
         _alBufferData **ptr = buffer->data;
 
+        start = buffer->start;
+        max = buffer->max_allocations;
         if (start)
         {
+            assert(!(buffer->mode & BUFFER_PTR_INDEX));
+
             max -= start;
 
             memmove(ptr, ptr+start, max*sizeof(void*));
             memset(ptr+max, 0, start*sizeof(void*));
             buffer->start = 0;
-            rv = -1;
+            __alBufMapRebuild(buffer);
+            BUFFER_COUNT(id, moves, 1);
         }
         else			/* increment buffer size */
         {
-            max = BUFFER_INCREMENT(buffer->max_allocations);
-
-            ptr = realloc(buffer->data, max*sizeof(_alBufferData*));
+            max = BUFFER_INCREMENT(buffer->num_allocated+num);
+
+            /*
+             * Never realloc the array in place, lock-free readers might
+             * still be using the old one.
+             */
+            ptr = NULL;
+            if (__alBufMapResize(buffer, max)) {
+                ptr = calloc(max, sizeof(_alBufferData*));
+            }
             if (ptr)
             {
-                unsigned int size;
-
-                buffer->data = ptr;
+                size_t size = buffer->max_allocations*sizeof(_alBufferData*);
+                _alBufferData **old = buffer->data;
 
-                ptr += buffer->max_allocations;
-                size = max - buffer->max_allocations;
-                memset(ptr, 0, size*sizeof(_alBufferData*));
+                memcpy(ptr, old, size);
 
-                buffer->max_allocations = max;
-                rv = -1;
+                /* publish the new array before the old one can be freed */
+                _oal_atomic_store(&buffer->data, ptr);
+                _oal_atomic_store(&buffer->max_allocations, max);
+                _alEpochRetire(old, free);
+                BUFFER_COUNT(id, grows, 1);
+            }
+            else {
+                rv = 0;
             }
         }
     }
-    else {
-        rv = -1;
-    }
 
 #ifdef BUFFER_DEBUG
-    if (buffer->data[buffer->start+buffer->first_free] != 0)
+    if (!(buffer->mode & BUFFER_HANDLES) &&
+        buffer->data[buffer->start+buffer->first_free] != 0)
     {
         unsigned int i;
 
@@ -908,7 +1751,8 @@ __alBufFreeSpace(_alBuffers *buffer, int id, char locked)
         printf("\n");
     }
 
-    assert(buffer->start+buffer->first_free < buffer->max_allocations);
+    assert((buffer->mode & BUFFER_HANDLES) ||
+           buffer->start+buffer->first_free < buffer->max_allocations);
 //  assert(buffer->data[buffer->start+buffer->first_free] == 0);
 #endif
 
@@ -919,3 +1763,58 @@ __alBufFreeSpace(_alBuffers *buffer, int id, char locked)
     return rv;
 }
 
+#ifndef _AL_NOTHREADS
+/*
+ * Lock the buffer array, when counting is enabled the time it took to get
+ * the lock is added to the counters of the buffer id.
+ */
+static void
+__alBufLock(_alBuffers *buffer, char *file, int line)
+{
+# if BUFFER_STATS
+    if (__alBufStatsOn())
+    {
+        uint64_t dt = nsecTime();
+
+        if (file) _aaxMutexLockDebug(buffer->mutex, file, line);
+        else _aaxMutexLock(buffer->mutex);
+
+        dt = nsecTime() - dt;
+        BUFFER_COUNT(buffer->id, wait_ns, dt);
+        if (dt > BUFFER_STATS_CONTENDED) {
+            BUFFER_COUNT(buffer->id, contended, 1);
+        }
+    }
+    else
+# endif
+    if (file) _aaxMutexLockDebug(buffer->mutex, file, line);
+    else _aaxMutexLock(buffer->mutex);
+}
+#endif
+
+#if BUFFER_STATS
+static int
+__alBufStatsInit()
+{
+    const char *env = getenv("OPENAL_ENABLE_BUFFER_STATS");
+    int enabled = 0;
+
+    if (env && (!strcasecmp(env, "true") || atoi(env))) {
+        enabled = 1;
+    }
+    _oal_atomic_store(&__alBufStatsEnabled, enabled);
+
+    return enabled;
+}
+
+static void
+__alBufCountPeak(unsigned int id, unsigned int num)
+{
+    if (__alBufStatsOn() && id < BUFFER_STATS_MAX_ID)
+    {
+        unsigned int peak = _oal_atomic_load(&__alBufCounters[id].peak);
+        while (peak < num && !_oal_atomic_cas(&__alBufCounters[id].peak, &peak, num));
+    }
+}
+#endif
+
@@ -16,6 +16,9 @@
 
 #include <limits.h>		/* for UINT_MAX */
 
+#include "slab.h"
+#include "epoch.h"
+
 #ifndef NDEBUG
 # define BUFFER_DEBUG		1
 # define NDEBUGTHREADS		1
@@ -24,20 +27,28 @@
 # define NDEBUGTHREADS		0
 #endif
 
+typedef void _alBufFreeCallback(void *);
+
+/*
+ * Objects carry no lock of their own. reference_ctr counts the number of
+ * buffer arrays which refer to the object, lock_ctr the number of
+ * outstanding _alBufGet calls plus one for as long as reference_ctr is
+ * non-zero. The object is freed as soon as lock_ctr drops to zero, and so
+ * is the user data when it was removed using _alBufRemoveRelease.
+ */
 typedef struct
 {
-#ifndef _AL_NOTHREADS
-    void *mutex;
-#endif
-
     unsigned int reference_ctr;
+    unsigned int lock_ctr;
     const void *ptr;
+    _alBufFreeCallback *cb_free;	/* frees ptr on the last release */
 
 } _alBufferData;
 
 typedef struct
 {
     unsigned int id;
+    unsigned int mode;			/* BUFFER_HANDLES, ...		 */
 
     void *mutex;
     unsigned int lock_ctr;
@@ -48,16 +59,71 @@ typedef struct
     unsigned int max_allocations;	/* max. no. allocations possible */
 					/* without the need te resize	 */
     _alBufferData **data;
+    unsigned int *occupied;		/* bitmap of used positions	 */
 
-} _alBuffers;
+    unsigned int *generation;		/* per slot, BUFFER_HANDLES only */
+    unsigned int *recycle;		/* FIFO of removed slots, idem	 */
+    unsigned int recycle_start;
+    unsigned int recycle_num;
+    unsigned int unused;		/* first slot never used, idem	 */
+    void *index;			/* BUFFER_PTR_INDEX only	 */
+    _alSlab *slab;			/* _alBufferData objects	 */
 
-typedef void _alBufFreeCallback(void *);
+} _alBuffers;
 
 
 #define BUFFER_RESERVE		8
 #define _alBufPosToId(a)	((a) == UINT_MAX) ? 0 : (((a) + 1) << 4)
 #define _alBufIdToPos(a)	(((a) == 0) || ((a) & 0xF))  ? UINT_MAX : (((a) >> 4) - 1)
-	
+
+/*
+ * Generational handle tables.
+ *
+ * The slot index (plus one) lives in the lower BUFFER_HANDLE_BITS bits of
+ * the handle and the slot generation in the upper bits. The generation of
+ * a slot is incremented whenever its object gets removed which turns every
+ * handle that still refers to the old object into a stale handle.
+ *
+ * Slots which were never used are handed out first. Removed slots are
+ * reused in the order in which they were removed, and only when more than
+ * BUFFER_HANDLE_RECYCLE of them are waiting, unless the table reached
+ * BUFFER_HANDLE_MAX. So a slot is reused at most once every
+ * BUFFER_HANDLE_RECYCLE removals and a stale handle only becomes valid
+ * again after its slot was reused BUFFER_GENERATION_MAX+1 times.
+ *
+ * Lookups do not take any lock, see "Lock-free readers" below.
+ */
+#define BUFFER_HANDLES		0x01
+
+/*
+ * Keep a hash index from user data pointer to position which turns
+ * _alBufGetPos into a constant time operation. The index is kept in sync
+ * by _alBufAddData, _alBufAddReference, _alBufReplace and _alBufRemove.
+ * It can not be combined with _alBufPop and _alBufPush.
+ */
+#define BUFFER_PTR_INDEX	0x02
+
+/*
+ * Lock-free readers.
+ *
+ * Pointer arrays are never reallocated in place: a grown array is published
+ * atomically and both the old array and removed objects are handed to the
+ * epoch based reclamation of base/epoch.h. _alBufGet is safe to call while
+ * other threads add or remove objects. The pointer returned by
+ * _alBufGetNoLock stays valid only while the caller either holds the buffer
+ * lock or is inside an _alEpochEnter/_alEpochLeave section.
+ *
+ * Tables which are used as a queue (_alBufPop/_alBufPush) move their start
+ * position in place and still require the buffer lock for all access.
+ */
+
+#define BUFFER_HANDLE_BITS	24
+#define BUFFER_HANDLE_MASK	((1 << BUFFER_HANDLE_BITS) - 1)
+#define BUFFER_HANDLE_MAX	(BUFFER_HANDLE_MASK - 1)
+#define BUFFER_HANDLE_RECYCLE	1024
+#define BUFFER_GENERATION_MAX	(UINT_MAX >> BUFFER_HANDLE_BITS)
+#define BUFFER_GENERATION(a)	((a) & BUFFER_GENERATION_MAX)
+
 
 /**
  * Setup the structure for an internal buffer array
@@ -78,15 +144,66 @@ typedef void _alBufFreeCallback(void *);
               UINT_MAX otherwise.
  */
 #ifdef BUFFER_DEBUG
-# define _alBufCreate(a, b)  _alBufCreateDebug(a, b, __FILE__, __LINE__)
+# define _alBufCreate(a, b)  _alBufCreateDebug(a, b, 0, __FILE__, __LINE__)
 unsigned int
-_alBufCreateDebug(_alBuffers **, unsigned int, char *, int);
+_alBufCreateDebug(_alBuffers **, unsigned int, unsigned int, char *, int);
 #else
-# define _alBufCreate(a, b)  _alBufCreateNormal(a, b)
+# define _alBufCreate(a, b)  _alBufCreateNormal(a, b, 0)
 #endif
 
 unsigned int
-_alBufCreateNormal(_alBuffers **, unsigned int);
+_alBufCreateNormal(_alBuffers **, unsigned int, unsigned int);
+
+
+/**
+ * Setup the structure for an internal buffer array with additional
+ * features.
+ *
+ * For BUFFER_HANDLES positions should be converted to handles using
+ * _alBufPosToHandle and handles back to positions using _alBufHandleToPos.
+ *
+ * @param buffer pointer to the root of the internal buffer structure
+ * @param id the id of the buffer this array should represent
+ * @param mode a combination of BUFFER_HANDLES and BUFFER_PTR_INDEX
+ * @return zero upon success, UINT_MAX otherwise.
+ */
+#ifdef BUFFER_DEBUG
+# define _alBufCreateMode(a, b, c)  _alBufCreateDebug(a, b, c, __FILE__, __LINE__)
+#else
+# define _alBufCreateMode(a, b, c)  _alBufCreateNormal(a, b, c)
+#endif
+
+
+/**
+ * Convert a position in the array to the handle of the object stored there.
+ *
+ * For arrays which where not created with BUFFER_HANDLES this equals
+ * _alBufPosToId.
+ *
+ * @param buffer the buffer the position belongs to
+ * @param id the id of the buffer this array should represent
+ * @param pos the position in the array
+ * @return the handle of the object or 0 if pos equals UINT_MAX
+ */
+unsigned int
+_alBufPosToHandle(const _alBuffers *, unsigned int, unsigned int);
+
+
+/**
+ * Convert an object handle back to it's position in the array.
+ *
+ * This function does not lock and can safely be called while other threads
+ * add or remove objects. Handles of removed objects are detected as stale.
+ * For arrays which where not created with BUFFER_HANDLES this equals
+ * _alBufIdToPos.
+ *
+ * @param buffer the buffer the handle belongs to
+ * @param id the id of the buffer this array should represent
+ * @param handle the handle to convert
+ * @return the position in the array or UINT_MAX if the handle is invalid
+ */
+unsigned int
+_alBufHandleToPos(const _alBuffers *, unsigned int, unsigned int);
 
 
 /**
@@ -115,11 +232,30 @@ unsigned int
 _alBufAddDataNormal(_alBuffers *, unsigned int, const void *, char);
 
 
+/**
+ * Add a number of new objects to the buffer list.
+ *
+ * Room for all objects is reserved at once and all objects are added
+ * while holding the buffer lock just once. Either all objects are added
+ * or none at all.
+ *
+ * @param buffer the buffer to add the data to
+ * @param id the id of the buffer this array should represent
+ * @param data array of 'num' pointers to the objects to add
+ * @param num the number of objects to add
+ * @param pos array which receives the 'num' positions of the new objects
+ * @return the number of objects added upon success, UINT_MAX otherwise.
+ */
+unsigned int
+_alBufAddDataBatch(_alBuffers *, unsigned int, const void **, unsigned int,
+                                                                unsigned int*);
+
+
 /**
  * Refer a buffer from another buffer list. No data is copied.
  *
- * The referer has to make sure that buffer->mutex and data->mutex are locked
- * prior to calling this function.
+ * The referer has to make sure that buffer->mutex is locked prior to calling
+ * this function.
  *
  * @param buffer the buffer to add the reference to
  * @param id the id of the buffer this array should represent
@@ -146,10 +282,11 @@ _alBufReplace(_alBuffers *, unsigned int, unsigned int, void *);
 
 /**
  * Get the data from a specific object in the array.
- * Lock the data before returning.
+ * Acquire a reference to the data before returning, the object will not be
+ * freed until the reference is dropped again using _alBufReleaseData.
  *
- * The referer has to make sure that buffer->mutex is locked before
- * calling this function.
+ * Acquiring a reference does not provide mutual exclusion for the user
+ * data of the object.
  *
  * @param buffer the buffer to get the data from
  * @param id the id of the buffer this array should represent
@@ -170,7 +307,10 @@ _alBufGetNormal(_alBuffers *, unsigned int, unsigned int, char);
 
 /**
  * Get the data from a specific object in the array.
- * Do not lock the data before returning.
+ * Do not acquire a reference to the data before returning.
+ *
+ * The caller has to hold the buffer lock or has to be inside an epoch
+ * section (_alEpochEnter) for as long as it uses the returned object.
  *
  * @param buffer the buffer to get the data from
  * @param id the id of the buffer this array should represent
@@ -181,40 +321,61 @@ _alBufGetNormal(_alBuffers *, unsigned int, unsigned int, char);
 
 
 /**
- * Unlock the data associated with a specific buffer position
+ * Acquire another reference to an object without looking it up again,
+ * for instance to hand out an object which was cached by the caller.
+ * The object memory must be known to be valid, either because the caller
+ * holds a reference or because it is inside an _alEpochEnter section and
+ * the object was valid when the section was entered.
+ *
+ * @param object the object to acquire a reference to, may be NULL
+ * @param id the id of the buffer this array should represent
+ * @return the object upon success or NULL if it is already being freed.
+ */
+_alBufferData *
+_alBufAcquireData(_alBufferData *, unsigned int);
+
+
+/**
+ * Drop the reference to the data associated with a specific buffer position
  *
  * @param buffer the buffer to get the data from
  * @param id the id of the buffer this array should represent
- * @param pos the position in the array of the opbject to unlock
+ * @param pos the position in the array of the opbject to release
  */
-#ifndef _AL_NOTHREADS
 void
 _alBufRelease(_alBuffers *, unsigned int, unsigned int);
-#else
-# define _alBufRelease(a, b, c)
-#endif
 
 
 /**
- * Release a previously locked data entry.
+ * Drop a reference that was previously acquired using _alBufGet.
+ * Free the object if it was removed from all buffer arrays in the mean time.
  *
- * @param object the object to unlock
+ * @param object the object to release, may be NULL
  * @param id the id of the buffer this array should represent
  */
-#ifndef _AL_NOTHREADS
-# ifndef NDEBUG
-#  define _alBufReleaseData(a, b)  _alBufReleaseDataDebug((a), (b), __FILE__, __LINE__)
+#ifndef NDEBUG
+# define _alBufReleaseData(a, b)  _alBufReleaseDataDebug((a), (b), __FILE__, __LINE__)
 void
 _alBufReleaseDataDebug(const _alBufferData*, unsigned int, char*, int);
-# else
-#  define _alBufReleaseData(a, b)  _alBufReleaseDataNormal(a, b)
-# endif
+#else
+# define _alBufReleaseData(a, b)  _alBufReleaseDataNormal(a, b)
+#endif
 
 void
 _alBufReleaseDataNormal(const _alBufferData *, unsigned int);
-#else
-# define _alBufReleaseData(a, b)
-#endif
+
+/**
+ * Make room for at least 'num' more objects in the array so adding them
+ * doesn't need to grow it.
+ *
+ * @param buffer the buffer to grow
+ * @param id the id of the buffer this array should represent
+ * @param num the number of objects to make room for
+ * @return non-zero upon success, zero if memory ran out.
+ */
+int
+_alBufReserve(_alBuffers *, unsigned int, unsigned int);
+
 
 /**
  * Return the number of allocated objects.
@@ -243,6 +404,74 @@ unsigned int
 _alBufGetMaxNumNoLock(const _alBuffers *, unsigned int);
 
 
+/**
+ * Get the usage statistics of the allocator for the objects of the array.
+ *
+ * @param buffer the buffer to get the statistics from
+ * @param id the id of the buffer this array should represent
+ * @param stats the structure to fill in
+ */
+void
+_alBufGetStats(const _alBuffers *, unsigned int, _alSlabStats *);
+
+
+/**
+ * Contention and latency counters, accumulated per buffer id over all
+ * buffer arrays with that id.
+ *
+ * The counters are compiled in unless BUFFER_STATS is defined as 0 and
+ * only updated when the OPENAL_ENABLE_BUFFER_STATS environment variable
+ * is set to true or a non-zero number.
+ */
+#ifndef BUFFER_STATS
+# define BUFFER_STATS		1
+#endif
+#define BUFFER_STATS_MAX_ID	16
+#define BUFFER_STATS_CONTENDED	10000	/* ns, lock waits above are contended */
+
+typedef struct
+{
+    unsigned long long lookups;		/* no. object lookups		 */
+    unsigned long long retries;		/* no. lost reference updates	 */
+    unsigned long long locks;		/* no. array lock acquisitions	 */
+    unsigned long long contended;	/* no. contended acquisitions	 */
+    unsigned long long wait_ns;		/* total time waited for locks	 */
+    unsigned long long grows;		/* no. times the array grew	 */
+    unsigned long long moves;		/* no. queue compactions	 */
+    unsigned int peak;			/* max. no. objects in one array */
+
+} _alBufCounters;
+
+
+/**
+ * Get the counters for a buffer id.
+ *
+ * @param id the id of the buffer arrays
+ * @param counters the structure to fill in
+ * @return non-zero if counting is enabled, zero otherwise.
+ */
+int
+_alBufGetCounters(unsigned int, _alBufCounters *);
+
+
+/**
+ * Reset the counters of all buffer ids.
+ */
+void
+_alBufResetCounters(void);
+
+
+/**
+ * Print the counters of all buffer ids which were used to stderr.
+ * Nothing is printed when counting is disabled.
+ *
+ * @param names the names of the buffer ids, indexed by id
+ * @param num the number of entries in names
+ */
+void
+_alBufDumpCounters(const char *[], unsigned int);
+
+
 /**
  * Lock the buffer and return the number of allocated objects.
  *
@@ -301,6 +530,9 @@ _alBufReleaseNumNormal(_alBuffers *, unsigned int, char);
 /**
  * Return the position of an object.
  *
+ * This is a constant time operation for buffers created with
+ * BUFFER_PTR_INDEX and a linear search otherwise.
+ *
  * @param buffer the buffer to get the data from
  * @param id the id of the buffer this array should represent
  * @param data the object to search for
@@ -336,6 +568,47 @@ void *
  _alBufRemoveNormal(_alBuffers *, unsigned int, unsigned int, char, char);
 
 
+/**
+ * Remove a buffer from the array and free it's user data as soon as no
+ * other thread holds a reference to it anymore.
+ *
+ * Unlike _alBufRemove this is safe while other threads might still be
+ * using the object they got from _alBufGet: the callback is called by
+ * whoever releases the last reference, which may be the caller itself
+ * before this function returns.
+ *
+ * @param buffer the buffer to remove the object from
+ * @param id the id of the buffer this array should represent
+ * @param pos the position of the buffer to remove
+ * @param cb_free the function which frees the user data
+ * @return non zero if an object was removed, zero otherwise.
+ */
+int
+_alBufRemoveRelease(_alBuffers *, unsigned int, unsigned int,
+                                  _alBufFreeCallback *);
+
+
+/**
+ * Remove a number of buffers from the array while holding the buffer lock
+ * just once.
+ *
+ * The user data of every object which is no longer referenced by any other
+ * buffer is returned in 'data' and it's up to the developer to use it or
+ * free it from memory. Empty positions and positions set to UINT_MAX are
+ * skipped and return NULL.
+ *
+ * @param buffer the buffer to remove the objects from
+ * @param id the id of the buffer this array should represent
+ * @param pos array of 'num' positions of the buffers to remove
+ * @param num the number of positions
+ * @param data array which receives the 'num' user data pointers, may be NULL
+ * @return the number of objects removed from the array
+ */
+unsigned int
+_alBufRemoveBatch(_alBuffers *, unsigned int, const unsigned int *,
+                                                      unsigned int, void **);
+
+
 /**
  * Remove the first buffer from the array and shift the remaining buffers 
  * one position forward.
@@ -370,10 +643,10 @@ _alBufPopNormal(_alBuffers *, unsigned int, char);
  * @param buffer the buffer to remove the object from
  * @param id the id of the buffer this array should represent
  * @param buffer the buffer to add to the array
- * @return te user data from the first object in the array
+ * @return non zero upon success, zero if there was no room left.
  */
 #define _alBufPush(a, b, c) _alBufPushNormal(a, b, c, 0)
-void
+int
 _alBufPushNormal(_alBuffers *, unsigned int, const _alBufferData*, char);
 
 
@@ -381,6 +654,9 @@ _alBufPushNormal(_alBuffers *, unsigned int, const _alBufferData*, char);
  * Free all entries form the array by calling a callback funtion to remove
  * the objects. This function is non recursive.
  *
+ * Objects which are still referenced by another thread are freed when
+ * that thread releases it's reference, as with _alBufRemoveRelease.
+ *
  * @param buffer the buffer to remove the object from
  * @param id the id of the buffer this array should represent
  * @param function a pointer to the callback function
@@ -433,6 +709,9 @@ _alBufGetDataPtr(const _alBufferData *);
 /**
  * Set the pointer to new user data from an object
  *
+ * This function does not update the BUFFER_PTR_INDEX index of the buffer
+ * arrays referring to the object, use _alBufReplace for those.
+ *
  * @param object a pointer tot the object
  * @param data a pointer to the new user data
  * @return a pointer to the old user data.
@@ -0,0 +1,340 @@
+/*
+ * SPDX-FileCopyrightText: Copyright © 2005-2023 by Erik Hofman.
+ * SPDX-FileCopyrightText: Copyright © 2009-2023 by Adalin B.V.
+ *
+ * Package Name: AeonWave Audio eXtentions library.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only
+ */
+
+#if HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#if HAVE_ASSERT_H
+#include <assert.h>
+#endif
+#include <stdlib.h>
+#include <limits.h>
+#if HAVE_PTHREAD_H
+# include <pthread.h>
+#endif
+
+#include "types.h"
+#include "epoch.h"
+#include "atomic.h"
+
+/* no. retired objects after which the epoch is advanced */
+#define EPOCH_THRESHOLD		64
+
+/*
+ * The epoch fits in 31 bits of the thread state and wraps at a multiple of
+ * three so the limbo list of an epoch is always epoch % 3, also at the wrap.
+ */
+#define EPOCH_WRAP		(((UINT_MAX >> 1)/3)*3)
+
+/*
+ * One record per thread which ever entered a section. Records of threads
+ * which have exited are reused by new threads, when the platform allows
+ * to detect thread exit.
+ */
+typedef struct _alEpochThread_s
+{
+    unsigned int state;			/* (epoch << 1) | 1 when active	 */
+    unsigned int nesting;		/* owner thread only		 */
+    unsigned int in_use;
+    struct _alEpochThread_s *next;
+    char pad[64 - 3*sizeof(unsigned int) - sizeof(void*)];
+
+} _alEpochThread;
+
+typedef struct
+{
+    void *ptr;
+    _alEpochFreeCallback *cb_free;
+
+} _alEpochItem;
+
+typedef struct
+{
+    _alEpochItem *item;
+    unsigned int num;
+    unsigned int max;
+
+} _alEpochLimbo;
+
+static unsigned int __alEpoch = 0;
+static unsigned int __alEpochLock = 0;	/* protects the limbo lists	 */
+static unsigned int __alEpochPending = 0;
+static _alEpochLimbo __alEpochLimbo[3];
+static _alEpochThread *__alEpochThreads = NULL;
+static unsigned int __alEpochDisabled = 0;
+static THREAD_LOCAL _alEpochThread *__alEpochSelf = NULL;
+
+static _alEpochThread *__alEpochRegister(void);
+static int __alEpochAdvance(_alEpochLimbo *);
+static void __alEpochFree(_alEpochLimbo *);
+static void __alEpochLockAcquire(void);
+static void __alEpochLockRelease(void);
+
+
+void
+_alEpochEnter(void)
+{
+    _alEpochThread *self = __alEpochSelf;
+
+    if (!self && (self = __alEpochRegister()) == NULL)
+    {
+        /* a reader we can't track, stop freeing anything */
+        _oal_atomic_store(&__alEpochDisabled, 1);
+        return;
+    }
+
+    if (self->nesting++ == 0)
+    {
+        unsigned int epoch = _oal_atomic_load(&__alEpoch);
+        _oal_atomic_store(&self->state, (epoch << 1) | 1);
+        _oal_atomic_fence();
+    }
+}
+
+void
+_alEpochLeave(void)
+{
+    _alEpochThread *self = __alEpochSelf;
+
+    if (self)
+    {
+        assert(self->nesting > 0);
+        if (--self->nesting == 0) {
+            _oal_atomic_store(&self->state, 0);
+        }
+    }
+}
+
+void
+_alEpochRetire(void *ptr, _alEpochFreeCallback *cb_free)
+{
+    _alEpochLimbo done = { NULL, 0, 0 };
+    _alEpochLimbo *limbo;
+
+    assert(cb_free);
+
+    if (!ptr) return;
+
+    __alEpochLockAcquire();
+
+    limbo = &__alEpochLimbo[__alEpoch % 3];
+    if (limbo->num == limbo->max)
+    {
+        unsigned int max = limbo->max ? 2*limbo->max : EPOCH_THRESHOLD;
+        _alEpochItem *item;
+
+        item = realloc(limbo->item, max*sizeof(_alEpochItem));
+        if (item)
+        {
+            limbo->item = item;
+            limbo->max = max;
+        }
+    }
+
+    if (limbo->num < limbo->max)
+    {
+        limbo->item[limbo->num].ptr = ptr;
+        limbo->item[limbo->num].cb_free = cb_free;
+        limbo->num++;
+
+        if (++__alEpochPending >= EPOCH_THRESHOLD) {
+            __alEpochAdvance(&done);
+        }
+    }
+    /* else: out of memory, leak the object rather than risk a crash */
+
+    __alEpochLockRelease();
+
+    __alEpochFree(&done);
+}
+
+void
+_alEpochSynchronize(void)
+{
+    _alEpochLimbo done = { NULL, 0, 0 };
+    int i;
+
+    __alEpochLockAcquire();
+    for (i=0; i<3; i++)
+    {
+        if (!__alEpochPending || !__alEpochAdvance(&done)) break;
+        __alEpochLockRelease();
+
+        __alEpochFree(&done);
+        done.item = NULL;
+        done.num = done.max = 0;
+
+        __alEpochLockAcquire();
+    }
+    __alEpochLockRelease();
+
+    __alEpochFree(&done);
+}
+
+void
+_alEpochWait(void)
+{
+    _alEpochThread *self = __alEpochSelf;
+    unsigned int advanced = 0;
+
+    if (self && self->nesting)
+    {
+        _alEpochSynchronize();
+        return;
+    }
+
+    /* three advances free everything which is in limbo right now */
+    while (advanced < 3 && !_oal_atomic_load(&__alEpochDisabled))
+    {
+        _alEpochLimbo done = { NULL, 0, 0 };
+        int progress = 0;
+
+        __alEpochLockAcquire();
+        if (!__alEpochPending) {
+            advanced = 3;
+        } else if (__alEpochAdvance(&done)) {
+            progress = -1;
+            advanced++;
+        }
+        __alEpochLockRelease();
+
+        __alEpochFree(&done);
+
+        /* some reader is still inside a section of the previous epoch */
+        if (!progress && advanced < 3) {
+            msecSleep(1);
+        }
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void
+__alEpochLockAcquire(void)
+{
+    unsigned int expected = 0;
+    while (!_oal_atomic_cas(&__alEpochLock, &expected, 1)) {
+        expected = 0;
+    }
+}
+
+static void
+__alEpochLockRelease(void)
+{
+    _oal_atomic_store(&__alEpochLock, 0);
+}
+
+/*
+ * Advance the global epoch if every active thread has observed the current
+ * one. Objects retired two epochs ago can't be seen by anyone anymore, they
+ * are moved to 'done' so the caller can free them after releasing the lock.
+ * The caller has to hold the limbo lock.
+ */
+static int
+__alEpochAdvance(_alEpochLimbo *done)
+{
+    unsigned int epoch = __alEpoch;
+    _alEpochThread *t;
+    _alEpochLimbo *limbo;
+
+    /* the caller frees at most one list at a time */
+    if (done->num || _oal_atomic_load(&__alEpochDisabled)) return 0;
+
+    _oal_atomic_fence();
+    for (t = _oal_atomic_load(&__alEpochThreads); t; t = t->next)
+    {
+        unsigned int state = _oal_atomic_load(&t->state);
+        if ((state & 1) && (state >> 1) != epoch) {
+            return 0;
+        }
+    }
+
+    limbo = &__alEpochLimbo[(epoch+1) % 3];
+    *done = *limbo;
+    limbo->item = NULL;
+    limbo->num = limbo->max = 0;
+    __alEpochPending -= done->num;
+
+    _oal_atomic_store(&__alEpoch, (epoch+1) % EPOCH_WRAP);
+
+    return -1;
+}
+
+static void
+__alEpochFree(_alEpochLimbo *limbo)
+{
+    unsigned int i;
+
+    for (i=0; i<limbo->num; i++) {
+        limbo->item[i].cb_free(limbo->item[i].ptr);
+    }
+    free(limbo->item);
+}
+
+#if HAVE_PTHREAD_H
+static pthread_key_t __alEpochKey;
+static pthread_once_t __alEpochKeyOnce = PTHREAD_ONCE_INIT;
+
+static void
+__alEpochThreadExit(void *ptr)
+{
+    _alEpochThread *self = ptr;
+
+    self->nesting = 0;
+    _oal_atomic_store(&self->state, 0);
+    _oal_atomic_store(&self->in_use, 0);
+}
+
+static void
+__alEpochKeyCreate(void)
+{
+    pthread_key_create(&__alEpochKey, __alEpochThreadExit);
+}
+#endif
+
+static _alEpochThread *
+__alEpochRegister(void)
+{
+    _alEpochThread *t;
+
+    for (t = _oal_atomic_load(&__alEpochThreads); t; t = t->next)
+    {
+        unsigned int expected = 0;
+        if (_oal_atomic_cas(&t->in_use, &expected, 1)) break;
+    }
+
+    if (!t)
+    {
+        t = calloc(1, sizeof(_alEpochThread));
+        if (t)
+        {
+            _alEpochThread *head;
+
+            t->in_use = 1;
+            head = _oal_atomic_load(&__alEpochThreads);
+            do {
+                t->next = head;
+            }
+            while (!_oal_atomic_cas_ptr(&__alEpochThreads, &head, t));
+        }
+    }
+
+    if (t)
+    {
+#if HAVE_PTHREAD_H
+        pthread_once(&__alEpochKeyOnce, __alEpochKeyCreate);
+        pthread_setspecific(__alEpochKey, t);
+#endif
+        __alEpochSelf = t;
+    }
+
+    return t;
+}
+
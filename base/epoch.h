@@ -0,0 +1,84 @@
+/*
+ * SPDX-FileCopyrightText: Copyright © 2005-2023 by Erik Hofman.
+ * SPDX-FileCopyrightText: Copyright © 2009-2023 by Adalin B.V.
+ *
+ * Package Name: AeonWave Audio eXtentions library.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only
+ */
+
+#ifndef _AL_EPOCH_H
+#define _AL_EPOCH_H 1
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#if HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+/*
+ * Epoch based memory reclamation.
+ *
+ * Readers which access shared objects without holding a lock bracket the
+ * access with _alEpochEnter and _alEpochLeave. Writers hand objects which
+ * they have unlinked to _alEpochRetire instead of freeing them, the object
+ * is freed once every thread that might still see it has left the section
+ * it was in at the time.
+ *
+ * Sections may be nested and are cheap: entering the outermost section
+ * costs one store and a memory fence, leaving it a single store.
+ */
+typedef void _alEpochFreeCallback(void *);
+
+
+/**
+ * Enter a read side section for the calling thread.
+ */
+void
+_alEpochEnter(void);
+
+
+/**
+ * Leave a read side section for the calling thread.
+ */
+void
+_alEpochLeave(void);
+
+
+/**
+ * Free an object as soon as no reader can refer to it anymore.
+ *
+ * @param ptr the object to free
+ * @param cb_free the function which frees the object
+ */
+void
+_alEpochRetire(void *, _alEpochFreeCallback *);
+
+
+/**
+ * Free as many retired objects as possible right now.
+ *
+ * All retired objects are freed if no thread is inside a read side
+ * section. This function never waits for readers.
+ */
+void
+_alEpochSynchronize(void);
+
+
+/**
+ * Wait until every object which was retired before the call is freed.
+ *
+ * A thread can't wait for itself: when called from within a read side
+ * section this behaves like _alEpochSynchronize.
+ */
+void
+_alEpochWait(void);
+
+#if defined(__cplusplus)
+}  /* extern "C" */
+#endif
+
+#endif /* !_AL_EPOCH_H */
+
@@ -0,0 +1,291 @@
+/*
+ * SPDX-FileCopyrightText: Copyright © 2005-2023 by Erik Hofman.
+ * SPDX-FileCopyrightText: Copyright © 2009-2023 by Adalin B.V.
+ *
+ * Package Name: AeonWave Audio eXtentions library.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only
+ */
+
+#if HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#if HAVE_ASSERT_H
+#include <assert.h>
+#endif
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+# include <malloc.h>
+#endif
+
+#include "slab.h"
+#include "atomic.h"
+
+typedef struct _alSlabSlot_s
+{
+    struct _alSlabSlot_s *next;
+
+} _alSlabSlot;
+
+/*
+ * The chunk header occupies the first cache line of every chunk, the slots
+ * follow directly after it.
+ */
+typedef struct _alSlabChunk_s
+{
+    _alSlab *slab;
+    struct _alSlabChunk_s *next;
+
+} _alSlabChunk;
+
+#define SLAB_CHUNK_HEADER	SLAB_CACHE_LINE
+#define SLAB_CHUNK(a)		((_alSlabChunk*)((size_t)(a) & ~(size_t)(SLAB_CHUNK_SIZE-1)))
+
+struct _alSlab_s
+{
+    unsigned int lock;			/* protects local and chunks	 */
+    unsigned int refs;			/* owner + no. objects in use	 */
+
+    unsigned int slot_size;
+    unsigned int slots_per_chunk;
+    unsigned int num_chunks;
+    unsigned int peak;
+    unsigned int allocs;
+
+    _alSlabChunk *chunks;
+    _alSlabSlot *local;			/* free list of the allocator	 */
+    _alSlabSlot *remote;		/* objects freed by _alSlabFree	 */
+};
+
+static _alSlabChunk *__alSlabChunkCreate(_alSlab *);
+static void __alSlabRelease(_alSlab *);
+static void __alSlabLock(_alSlab *);
+static void __alSlabUnlock(_alSlab *);
+static void *__alSlabAlignedAlloc(size_t);
+static void __alSlabAlignedFree(void *);
+
+
+_alSlab *
+_alSlabCreate(size_t size)
+{
+    _alSlab *rv = NULL;
+
+    assert(size > 0);
+
+    if (size < SLAB_CACHE_LINE)
+    {
+        size_t slot_size = sizeof(_alSlabSlot);
+        while (slot_size < size) {
+            slot_size *= 2;
+        }
+        size = slot_size;
+    }
+    else {
+        size = (size + SLAB_CACHE_LINE-1) & ~(size_t)(SLAB_CACHE_LINE-1);
+    }
+
+    if (size <= (SLAB_CHUNK_SIZE - SLAB_CHUNK_HEADER)/4)
+    {
+        rv = calloc(1, sizeof(_alSlab));
+        if (rv)
+        {
+            rv->refs = 1;
+            rv->slot_size = size;
+            rv->slots_per_chunk = (SLAB_CHUNK_SIZE - SLAB_CHUNK_HEADER)/size;
+        }
+    }
+
+    return rv;
+}
+
+void
+_alSlabDestroy(_alSlab *slab)
+{
+    if (slab) {
+        __alSlabRelease(slab);
+    }
+}
+
+void *
+_alSlabAlloc(_alSlab *slab)
+{
+    _alSlabSlot *slot;
+
+    assert(slab);
+
+    __alSlabLock(slab);
+
+    slot = slab->local;
+    if (!slot) {
+        slot = _oal_atomic_exchange_ptr(&slab->remote, NULL);
+    }
+    if (!slot && __alSlabChunkCreate(slab)) {
+        slot = slab->local;
+    }
+
+    if (slot)
+    {
+        unsigned int used;
+
+        slab->local = slot->next;
+        used = _oal_atomic_add(&slab->refs, 1) - 1;
+        if (slab->peak < used) {
+            slab->peak = used;
+        }
+        slab->allocs++;
+    }
+
+    __alSlabUnlock(slab);
+
+    if (slot) {
+        memset(slot, 0, slab->slot_size);
+    }
+
+    return slot;
+}
+
+void
+_alSlabFree(void *ptr)
+{
+    if (ptr)
+    {
+        _alSlab *slab = SLAB_CHUNK(ptr)->slab;
+        _alSlabSlot *slot = ptr;
+        _alSlabSlot *head;
+
+        head = _oal_atomic_load(&slab->remote);
+        do {
+            slot->next = head;
+        }
+        while (!_oal_atomic_cas_ptr(&slab->remote, &head, slot));
+
+        __alSlabRelease(slab);
+    }
+}
+
+int
+_alSlabReserve(_alSlab *slab, unsigned int num)
+{
+    int rv = -1;
+
+    assert(slab);
+
+    __alSlabLock(slab);
+    while (rv && slab->num_chunks*slab->slots_per_chunk < num) {
+        rv = __alSlabChunkCreate(slab) ? -1 : 0;
+    }
+    __alSlabUnlock(slab);
+
+    return rv;
+}
+
+void
+_alSlabGetStats(const _alSlab *slab, _alSlabStats *stats)
+{
+    assert(stats);
+
+    memset(stats, 0, sizeof(_alSlabStats));
+    if (slab)
+    {
+        stats->slot_size = slab->slot_size;
+        stats->chunks = slab->num_chunks;
+        stats->total = slab->num_chunks*slab->slots_per_chunk;
+        stats->used = _oal_atomic_load(&slab->refs) - 1;
+        stats->peak = slab->peak;
+        stats->allocs = slab->allocs;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+/*
+ * Add a new chunk to the slab and put all of it's slots on the local free
+ * list, the caller has to hold the slab lock.
+ */
+static _alSlabChunk *
+__alSlabChunkCreate(_alSlab *slab)
+{
+    _alSlabChunk *chunk = __alSlabAlignedAlloc(SLAB_CHUNK_SIZE);
+    if (chunk)
+    {
+        char *ptr = (char*)chunk + SLAB_CHUNK_HEADER;
+        unsigned int i;
+
+        chunk->slab = slab;
+        chunk->next = slab->chunks;
+        slab->chunks = chunk;
+        slab->num_chunks++;
+
+        i = slab->slots_per_chunk;
+        ptr += i*slab->slot_size;
+        do
+        {
+            _alSlabSlot *slot;
+
+            ptr -= slab->slot_size;
+            slot = (_alSlabSlot*)ptr;
+            slot->next = slab->local;
+            slab->local = slot;
+        }
+        while (--i);
+    }
+    return chunk;
+}
+
+static void
+__alSlabRelease(_alSlab *slab)
+{
+    if (_oal_atomic_sub(&slab->refs, 1) == 0)
+    {
+        _alSlabChunk *chunk = slab->chunks;
+        while (chunk)
+        {
+            _alSlabChunk *next = chunk->next;
+            __alSlabAlignedFree(chunk);
+            chunk = next;
+        }
+        free(slab);
+    }
+}
+
+static void
+__alSlabLock(_alSlab *slab)
+{
+    unsigned int expected = 0;
+    while (!_oal_atomic_cas(&slab->lock, &expected, 1)) {
+        expected = 0;
+    }
+}
+
+static void
+__alSlabUnlock(_alSlab *slab)
+{
+    _oal_atomic_store(&slab->lock, 0);
+}
+
+static void *
+__alSlabAlignedAlloc(size_t size)
+{
+    void *rv;
+#ifdef _WIN32
+    rv = _aligned_malloc(size, size);
+#else
+    if (posix_memalign(&rv, size, size) != 0) {
+        rv = NULL;
+    }
+#endif
+    return rv;
+}
+
+static void
+__alSlabAlignedFree(void *ptr)
+{
+#ifdef _WIN32
+    _aligned_free(ptr);
+#else
+    free(ptr);
+#endif
+}
+
@@ -0,0 +1,117 @@
+/*
+ * SPDX-FileCopyrightText: Copyright © 2005-2023 by Erik Hofman.
+ * SPDX-FileCopyrightText: Copyright © 2009-2023 by Adalin B.V.
+ *
+ * Package Name: AeonWave Audio eXtentions library.
+ *
+ * SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only
+ */
+
+#ifndef _AL_SLAB_H
+#define _AL_SLAB_H 1
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#if HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stddef.h>
+
+/*
+ * Fixed size object allocator.
+ *
+ * Objects are handed out from chunks of SLAB_CHUNK_SIZE bytes which are
+ * aligned to their own size. The slot size is chosen per slab: objects of
+ * SLAB_CACHE_LINE bytes or more are rounded up to a multiple of it and
+ * never share a cache line, smaller objects are rounded up to a power of
+ * two so several of them fit in a cache line but none crosses one.
+ *
+ * Objects may be freed from any thread, even after the owner destroyed the
+ * slab: the slab stays around until the last object is returned to it.
+ */
+#define SLAB_CACHE_LINE		64
+#define SLAB_CHUNK_SIZE		16384
+
+typedef struct _alSlab_s _alSlab;
+
+typedef struct
+{
+    unsigned int slot_size;		/* size of one slot in bytes	 */
+    unsigned int chunks;		/* no. allocated chunks		 */
+    unsigned int total;			/* no. slots in all chunks	 */
+    unsigned int used;			/* no. slots currently in use	 */
+    unsigned int peak;			/* max. no. slots ever in use	 */
+    unsigned int allocs;		/* no. allocations since creation */
+
+} _alSlabStats;
+
+
+/**
+ * Create a new slab for objects of a fixed size.
+ *
+ * @param size the size of a single object in bytes
+ * @return a pointer to the new slab upon success, NULL otherwise.
+ */
+_alSlab *
+_alSlabCreate(size_t);
+
+
+/**
+ * Drop the owners reference to the slab. The slab and all of it's chunks
+ * are freed as soon as no object from it is in use anymore.
+ *
+ * @param slab the slab to destroy, may be NULL
+ */
+void
+_alSlabDestroy(_alSlab *);
+
+
+/**
+ * Get a zero initialized object from the slab.
+ *
+ * @param slab the slab to allocate the object from
+ * @return a pointer to the object upon success, NULL otherwise.
+ */
+void *
+_alSlabAlloc(_alSlab *);
+
+
+/**
+ * Return an object to the slab it was allocated from.
+ *
+ * @param ptr the object to free, may be NULL
+ */
+void
+_alSlabFree(void *);
+
+
+/**
+ * Make sure the slab holds at least 'num' objects, in use or free,
+ * without the need to allocate more memory.
+ *
+ * @param slab the slab to grow
+ * @param num the number of objects
+ * @return non-zero upon success, zero if memory ran out.
+ */
+int
+_alSlabReserve(_alSlab *, unsigned int);
+
+
+/**
+ * Get the usage statistics of a slab.
+ *
+ * @param slab the slab to get the statistics from
+ * @param stats the structure to fill in
+ */
+void
+_alSlabGetStats(const _alSlab *, _alSlabStats *);
+
+#if defined(__cplusplus)
+}  /* extern "C" */
+#endif
+
+#endif /* !_AL_SLAB_H */
+
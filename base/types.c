@@ -41,6 +41,19 @@ int msecSleep(unsigned int dt_ms)
    return (res != 0) ? -1 : 0;
 }
 
+/* monotonic time in nanoseconds, only useful for measuring intervals */
+uint64_t nsecTime()
+{
+   static LARGE_INTEGER freq = { 0 };
+   LARGE_INTEGER ctr;
+
+   if (!freq.QuadPart) QueryPerformanceFrequency(&freq);
+   QueryPerformanceCounter(&ctr);
+
+   return (uint64_t)(ctr.QuadPart/freq.QuadPart)*1000000000ULL
+          + (uint64_t)(ctr.QuadPart%freq.QuadPart)*1000000000ULL/freq.QuadPart;
+}
+
 #else	/* WIN32 */
 # include <errno.h>
 /*
@@ -49,7 +62,7 @@ int msecSleep(unsigned int dt_ms)
  */
 int msecSleep(unsigned int dt_ms)
 {
-   static struct timespec s;
+   struct timespec s;
    if (dt_ms > 0)
    {
       s.tv_sec = (dt_ms/1000);
@@ -65,5 +78,14 @@ int msecSleep(unsigned int dt_ms)
    }
    return 0;
 }
+
+/* monotonic time in nanoseconds, only useful for measuring intervals */
+uint64_t nsecTime()
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (uint64_t)ts.tv_sec*1000000000ULL + ts.tv_nsec;
+}
 #endif
 
@@ -70,7 +70,14 @@ typedef int size_t;
 #else
 #endif
 
+#if defined(_MSC_VER)
+# define THREAD_LOCAL	__declspec(thread)
+#else
+# define THREAD_LOCAL	__thread
+#endif
+
 int msecSleep(unsigned int);
+uint64_t nsecTime(void);
 
 #if defined(__cplusplus)
 }  /* extern "C" */
@@ -54,6 +54,44 @@ ALCEXT_API void ALCEXT_APIENTRY alcCaptureiAAX(ALCdevice * device, ALCenum attri
 ALCEXT_API void ALCEXT_APIENTRY alcGetCaptureivAAX(ALCdevice * device, ALCenum attrib, ALCint *value);
 #endif
 
+#ifndef ALC_AAX_pool_statistics
+# define ALC_AAX_pool_statistics 1
+# define ALC_SOURCE_POOL_SIZE_AAX		0x270030
+# define ALC_SOURCE_POOL_USED_AAX		0x270031
+# define ALC_SOURCE_POOL_PEAK_AAX		0x270032
+# define ALC_BUFFER_POOL_SIZE_AAX		0x270033
+# define ALC_BUFFER_POOL_USED_AAX		0x270034
+# define ALC_BUFFER_POOL_PEAK_AAX		0x270035
+#endif
+
+#ifndef ALC_AAX_context_hints
+# define ALC_AAX_context_hints 1
+# define ALC_MIXER_THREADS_AAX			0x270036
+# define ALC_PERIOD_SIZE_AAX			0x270037
+# define ALC_UPDATE_MODE_AAX			0x270038
+# define ALC_SOURCE_PREALLOC_AAX		0x270039
+# define ALC_BUFFER_PREALLOC_AAX		0x27003A
+# define ALC_MAX_VOICES_AAX			0x27003D
+
+/* ALC_UPDATE_MODE_AAX values */
+# define ALC_UPDATE_IMMEDIATE_AAX		0x27003B
+# define ALC_UPDATE_QUEUED_AAX			0x27003C
+#endif
+
+#ifndef ALC_AAX_async_open
+# define ALC_AAX_async_open 1
+# define ALC_DEVICE_STATE_AAX			0x27003E
+
+/* ALC_DEVICE_STATE_AAX values */
+# define ALC_DEVICE_OPENING_AAX			0x27003F
+# define ALC_DEVICE_READY_AAX			0x270040
+# define ALC_DEVICE_FAILED_AAX			0x270041
+typedef ALCdevice* (ALCEXT_APIENTRY *PFNALCOPENDEVICEASYNCAAXPROC)(const ALCchar *devicename);
+# ifdef AL_ALEXT_PROTOTYPES
+ALC_API ALCdevice* ALCEXT_APIENTRY alcOpenDeviceAsyncAAX(const ALCchar *devicename);
+# endif
+#endif
+
 #ifndef ALC_EXT_thread_local_context
 #define ALC_EXT_thread_local_context 1
 typedef ALCboolean  (ALCEXT_APIENTRY *PFNALCSETTHREADCONTEXTPROC)(ALCcontext *context);
@@ -264,6 +264,19 @@ ALEXT_API ALboolean ALEXT_APIENTRY alIsBufferFormatSupportedSOFT(ALenum format);
 #define AL_REVERB_DECAY_TIME_HF_AAX		0x27000D
 #endif
 
+#ifndef AL_AAX_source_priority
+#define AL_AAX_source_priority 1
+#define AL_SOURCE_PRIORITY_AAX			0x27000E
+#endif
+
+#ifndef AL_AAX_source_batch
+#define AL_AAX_source_batch 1
+typedef void (ALEXT_APIENTRY*PFNALSOURCEFVBATCHAAXPROC)(ALsizei,const ALuint*,ALenum,const ALfloat*);
+# ifdef AL_ALEXT_PROTOTYPES
+ALEXT_API void ALEXT_APIENTRY alSourcefvBatchAAX(ALsizei num, const ALuint *ids, ALenum attrib, const ALfloat *values);
+# endif
+#endif
+
 #ifndef AL_AAX_distance_delay_model
 #define AL_AAX_distance_delay_model 1
 #define AL_DISTANCE_DELAY_MODEL_AAX		0x27D000
@@ -32,6 +32,9 @@
 #if HAVE_UNISTD_H
 # include <unistd.h>	/* for sysconf */
 #endif
+#if HAVE_PTHREAD_H
+# include <pthread.h>
+#endif
 
 #include <aax/aax.h>
 #include <AL/al.h>
@@ -462,8 +465,151 @@ _oalAAXGetCtxExtensions(const char** exts)
     return (const char *)retstr;
 }
 
+/*
+ * Enumerating the drivers instantiates every one of them which takes a
+ * noticeable amount of time. The results are cached and the enumeration
+ * is started in the background as soon as the library gets loaded, or by
+ * the first ALC call where there are no constructors. The getters below
+ * only have to wait for it when it didn't finish yet.
+ */
+static const char* _oalAAXDriverSpecifiers(enum aaxRenderMode);
+static const char* _oalAAXDeviceSpecifiersAll(enum aaxRenderMode);
+static const char* _oalAAXDefaultDriver(enum aaxRenderMode);
+
+static void
+_oalAAXDriverCacheFill(enum aaxRenderMode mode)
+{
+    _oalAAXDefaultDriver(mode);
+    _oalAAXDriverSpecifiers(mode);
+    _oalAAXDeviceSpecifiersAll(mode);
+}
+
+#if HAVE_PTHREAD_H
+static pthread_once_t _oalAAXDriverOnce[2] = {
+    PTHREAD_ONCE_INIT, PTHREAD_ONCE_INIT
+};
+
+static void
+_oalAAXDriverCacheRead(void)
+{
+    _oalAAXDriverCacheFill(AAX_MODE_READ);
+}
+
+static void
+_oalAAXDriverCacheWrite(void)
+{
+    _oalAAXDriverCacheFill(AAX_MODE_WRITE_STEREO);
+}
+#endif
+
+static void
+_oalAAXDriverCache(enum aaxRenderMode mode)
+{
+    int m = (mode == AAX_MODE_READ) ? 0 : 1;
+#if HAVE_PTHREAD_H
+    pthread_once(&_oalAAXDriverOnce[m],
+                 m ? _oalAAXDriverCacheWrite : _oalAAXDriverCacheRead);
+#else
+    static char done[2] = { 0, 0 };
+    if (!done[m])
+    {
+        _oalAAXDriverCacheFill(mode);
+        done[m] = 1;
+    }
+#endif
+}
+
+#if HAVE_PTHREAD_H
+static pthread_once_t _oalAAXDriverThreadOnce = PTHREAD_ONCE_INIT;
+
+static void *
+_oalAAXDriverThread(void *arg)
+{
+    _oalAAXDriverCache(AAX_MODE_WRITE_STEREO);
+    _oalAAXDriverCache(AAX_MODE_READ);
+    return NULL;
+}
+
+/*
+ * The thread is detached: nobody waits for a slow driver probe when the
+ * library gets unloaded or the process exits.
+ */
+static void
+_oalAAXDriverThreadStart(void)
+{
+    pthread_attr_t attr;
+    pthread_t thread;
+
+    if (!pthread_attr_init(&attr))
+    {
+        pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+        pthread_create(&thread, &attr, _oalAAXDriverThread, NULL);
+        pthread_attr_destroy(&attr);
+    }
+}
+#endif
+
+void
+_oalAAXDriverCacheStart(void)
+{
+#if HAVE_PTHREAD_H
+    pthread_once(&_oalAAXDriverThreadOnce, _oalAAXDriverThreadStart);
+#endif
+}
+
+#if HAVE_PTHREAD_H && defined(__GNUC__)
+/* only starts the detached thread, there is no destructor to join it */
+static void __attribute__((constructor))
+_oalAAXDriverCacheLoad(void)
+{
+    _oalAAXDriverCacheStart();
+}
+#endif
+
 const char*
 _oalAAXGetDriverSpecifiers(enum aaxRenderMode mode)
+{
+    _oalAAXDriverCache(mode);
+    return _oalAAXDriverSpecifiers(mode);
+}
+
+const char*
+_oalAAXGetDeviceSpecifiersAll(enum aaxRenderMode mode)
+{
+    _oalAAXDriverCache(mode);
+    return _oalAAXDeviceSpecifiersAll(mode);
+}
+
+const char*
+_oalAAXGetDefaultDriver(enum aaxRenderMode mode)
+{
+    _oalAAXDriverCache(mode);
+    return _oalAAXDefaultDriver(mode);
+}
+
+static const char*
+_oalAAXDefaultDriver(enum aaxRenderMode mode)
+{
+    static char retstr[2][128] = { "", "" };
+    int m = (mode == AAX_MODE_READ) ? 0 : 1;
+
+    if (retstr[m][0] == '\0')
+    {
+        aaxConfig cfg = aaxDriverGetByName(NULL, mode);
+        if (cfg)
+        {
+            const char *s = aaxDriverGetSetup(cfg, AAX_RENDERER_STRING);
+            snprintf(retstr[m], 128, "%s", s ? s : "");
+            retstr[m][127] = '\0';
+            aaxDriverDestroy(cfg);
+        }
+    }
+
+    return (const char *)retstr[m];
+}
+
+static const char*
+_oalAAXDriverSpecifiers(enum aaxRenderMode mode)
 {
     static char retstr[2][2048] = { "\0\0", "\0\0" };
     int m = (mode == AAX_MODE_READ) ? 0 : 1;
@@ -513,8 +659,8 @@ _oalAAXGetDriverSpecifiers(enum aaxRenderMode mode)
     return (const char *)retstr[m];
 }
 
-const char*
-_oalAAXGetDeviceSpecifiersAll(enum aaxRenderMode mode)
+static const char*
+_oalAAXDeviceSpecifiersAll(enum aaxRenderMode mode)
 {
     static char retstr[2][2048] = { "\0\0", "\0\0" };
     int m = (mode == AAX_MODE_READ) ? 0 : 1;
@@ -731,6 +877,8 @@ static const char* aaxCtxExtensions[] =
 {
   "ALC_EXT_capture",
   "ALC_AAX_capture_loopback",
+  "ALC_AAX_pool_statistics",
+  "ALC_AAX_context_hints",
 
   NULL				/* always last */
 };
@@ -741,6 +889,8 @@ static const char* aaxExtensions[] =
   "AL_AAX_distance_delay_model",
   "AL_AAX_frequency_filter",
   "AL_AAX_reverb",
+  "AL_AAX_source_priority",
+  "AL_AAX_source_batch",
 
   NULL				/* always last */
 };
@@ -756,6 +906,7 @@ static const _oalEnumValue_s aaxEnums[] =
   {"AL_LINEAR_DISTANCE_DELAY_CLAMPED_AAX",AL_LINEAR_DISTANCE_DELAY_CLAMPED_AAX},
   {"AL_EXPONENT_DISTANCE_DELAY_AAX",      AL_EXPONENT_DISTANCE_DELAY_AAX},
   {"AL_EXPONENT_DISTANCE_DELAY_CLAMPED_AAX",AL_EXPONENT_DISTANCE_DELAY_CLAMPED_AAX},
+  {"AL_SOURCE_PRIORITY_AAX",              AL_SOURCE_PRIORITY_AAX},
 
   {NULL, 0}				  /* always last */
 };
@@ -37,8 +37,10 @@ const _oalEnumValue_s *_oalAAXGetEnum(const char *name);
 
 const char* _oalAAXGetExtensions(const char**);
 const char* _oalAAXGetCtxExtensions(const char**);
+void _oalAAXDriverCacheStart(void);
 const char* _oalAAXGetDriverSpecifiers(enum aaxRenderMode);
 const char* _oalAAXGetDeviceSpecifiersAll(enum aaxRenderMode);
+const char* _oalAAXGetDefaultDriver(enum aaxRenderMode);
 ALCboolean _oalAAXGetExtensionSupport(const char *);
 ALCboolean _oalAAXGetCtxExtensionSupport(const char *);
 const char *_oalAAXGetVersionString(const void *);
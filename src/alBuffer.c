@@ -38,7 +38,9 @@ alIsBuffer(ALuint id)
     _alBufferData *dptr;
     ALuint pos;
 
+    _alEpochEnter();
     dptr = _oalFindBufferById(id, &pos);
+    _alEpochLeave();
 
     return dptr ? AL_TRUE : AL_FALSE;
 }
@@ -61,27 +63,29 @@ alGenBuffers(ALsizei num, ALuint *ids)
     db = _oalGetBuffers(NULL);
     if (db)
     {
-        ALuint pos = UINT_MAX;
-        int i;
+        const void **data = malloc(num * sizeof(void*));
+        ALuint r = UINT_MAX;
 
-        for (i=0; i<num; i++)
+        if (data)
         {
-            if ((pos = _alBufAddData(db, _OAL_BUFFER, null_buf)) == UINT_MAX) {
-                break;
-            }
+            ALsizei i;
 
-            ids[i] = _alBufPosToId(pos);
-        }
+            for (i=0; i<num; i++) {
+                data[i] = null_buf;
+            }
 
-        if (pos == UINT_MAX)
-        {
-            unsigned int r;
-            for (r=i; r != 0; --r)
+            /* all or nothing: no rollback is required on failure */
+            r = _alBufAddDataBatch(db, _OAL_BUFFER, data, num, ids);
+            if (r != UINT_MAX)
             {
-                pos = _alBufIdToPos(ids[r]);
-                _alBufRemove(db, _OAL_BUFFER, pos, AL_FALSE);
-                ids[r] = 0;
+                for (i=0; i<num; i++) {
+                    ids[i] = _alBufPosToHandle(db, _OAL_BUFFER, ids[i]);
+                }
             }
+            free(data);
+        }
+
+        if (r == UINT_MAX) {
             _oalStateSetError(AL_OUT_OF_MEMORY);
         }
     }
@@ -118,18 +122,18 @@ alDeleteBuffers(ALsizei num, const ALuint *ids)
         if (i == num)
         {
             _alBuffers *db = _oalGetBuffers(NULL);
-
-            i--;
-            do
+            void **bufs = malloc(num * sizeof(void*));
+            if (bufs)
             {
-                aaxBuffer buf;
-
-                buf = _alBufRemove(db, _OAL_BUFFER, pos[i], AL_FALSE);
-                if (buf) {
-                    aaxBufferDestroy(buf);
+                _alBufRemoveBatch(db, _OAL_BUFFER, pos, num, bufs);
+                for (i=0; i<num; i++) {
+                    _alEpochRetire(bufs[i], _oalFreeBuffer);
                 }
+                free(bufs);
+            }
+            else {
+                _oalStateSetError(AL_OUT_OF_MEMORY);
             }
-            while (i--);
         }
         else {
             _oalStateSetError(AL_INVALID_NAME);
@@ -153,6 +157,7 @@ alBufferData(ALuint id, ALenum format,
         return;
     }
 
+    _alEpochEnter();
     dptr = _oalFindBufferById(id, &pos);
     if (dptr)
     {
@@ -182,7 +187,7 @@ alBufferData(ALuint id, ALenum format,
                 if (new_buf)
                 {
                     _alBuffers *db = _oalGetBuffers(NULL);
-                    unsigned int pos = _alBufIdToPos(id);
+                    unsigned int pos = _alBufHandleToPos(db, _OAL_BUFFER, id);
 
                     aaxBufferSetSetup(new_buf, AAX_FREQUENCY, frequency);
                     aaxBufferSetData(new_buf, data);
@@ -207,6 +212,7 @@ alBufferData(ALuint id, ALenum format,
     else {
         _oalStateSetError(AL_INVALID_VALUE);
     }
+    _alEpochLeave();
 }
 
 
@@ -254,7 +260,9 @@ _oalGetBuffers(_oalDevice *d)
     {
         if (d->buffers == 0)
         {
-            unsigned int r =  _alBufCreate(&d->buffers, _OAL_BUFFER);
+            unsigned int r;
+            r = _alBufCreateMode(&d->buffers, _OAL_BUFFER,
+                                 BUFFER_HANDLES|BUFFER_PTR_INDEX);
             if (r == UINT_MAX) {
                 _oalContextSetError(ALC_OUT_OF_MEMORY);
             }
@@ -280,19 +288,17 @@ _oalFindBufferById(ALuint id, ALuint *pos)
 
     _AL_LOG(LOG_DEBUG, __FUNCTION__);
 
-    n = _alBufIdToPos(id);
-    if (n != UINT_MAX)
+    if (id)
     {
         _alBuffers *db = _oalGetBuffers(NULL);
         if (db)
         {
-            ALuint num = _alBufGetMaxNum(db, _OAL_BUFFER);
-            if (n < num)
+            n = _alBufHandleToPos(db, _OAL_BUFFER, id);
+            if (n != UINT_MAX)
             {
                 dptr = _alBufGetNoLock(db, _OAL_BUFFER, n);
                 *pos = n;
             }
-            _alBufReleaseNum(db, _OAL_BUFFER);
         }
     }
 
@@ -306,5 +312,7 @@ _oalFreeBuffer(void *buffer)
 
     _AL_LOG(LOG_DEBUG, __FUNCTION__);
 
-    aaxBufferDestroy(buf);
+    if (buf != null_buf) {
+        aaxBufferDestroy(buf);
+    }
 }
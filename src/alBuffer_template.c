@@ -64,6 +64,7 @@ ALBUFFERV(N)(ALuint id, ALenum attrib, const T *values)
         return;
     }
 
+    _alEpochEnter();
     dptr = _oalFindBufferById(id, &pos);
     if (dptr)
     {
@@ -81,6 +82,7 @@ ALBUFFERV(N)(ALuint id, ALenum attrib, const T *values)
     else {
         _oalStateSetError(AL_INVALID_NAME);
     }
+    _alEpochLeave();
 }
 
 AL_API void AL_APIENTRY
@@ -99,6 +101,7 @@ ALBUFFER(N)(ALuint id, ALenum attrib, T value)
         return;
     }
 
+    _alEpochEnter();
     dptr = _oalFindBufferById(id, &pos);
     if (dptr)
     {
@@ -121,6 +124,7 @@ ALBUFFER(N)(ALuint id, ALenum attrib, T value)
     else {
         _oalStateSetError(AL_INVALID_NAME);
     }
+    _alEpochLeave();
 }
 
 AL_API void AL_APIENTRY
@@ -150,6 +154,7 @@ ALGETBUFFERV(N)(ALuint id, ALenum attrib, T *values)
         return;
     }
 
+    _alEpochEnter();
     dptr = _oalFindBufferById(id, &pos);
     if (dptr)
     {
@@ -163,6 +168,7 @@ ALGETBUFFERV(N)(ALuint id, ALenum attrib, T *values)
     else {
         _oalStateSetError(AL_INVALID_NAME);
     }
+    _alEpochLeave();
 }
 
 AL_API void AL_APIENTRY
@@ -181,6 +187,7 @@ ALGETBUFFER(N)(ALuint id, ALenum attrib, T *value)
         return;
     }
 
+    _alEpochEnter();
     dptr = _oalFindBufferById(id, &pos);
     if (dptr)
     {
@@ -207,6 +214,7 @@ ALGETBUFFER(N)(ALuint id, ALenum attrib, T *value)
     else {
         _oalStateSetError(AL_INVALID_NAME);
     }
+    _alEpochLeave();
 }
 
 # undef __ALBUFFERV
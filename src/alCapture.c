@@ -36,21 +36,11 @@ ALC_API ALCdevice * ALC_APIENTRY
 alcCaptureOpenDevice(const ALCchar *name, ALCuint freq, ALCenum fmt, ALCsizei bufsize)
 {
     ALCdevice *device = 0;
-    unsigned int pos = 0;
     aaxConfig handle;
 
     _AL_LOG(LOG_INFO, __FUNCTION__);
 
-    if (_oalDevices == 0)
-    {
-        pos = _alBufCreate(&_oalDevices, _OAL_DEVICE);
-        if (pos == UINT_MAX)
-        {
-            _oalContextSetError(ALC_OUT_OF_MEMORY);
-            return 0;
-        }
-    }
-
+    _oalAAXDriverCacheStart();
     handle = aaxDriverOpenByName(name, AAX_MODE_READ);
     if (handle != NULL)
     {
@@ -82,15 +72,7 @@ alcCaptureOpenDevice(const ALCchar *name, ALCuint freq, ALCenum fmt, ALCsizei bu
 
             d->sync = 0;
             d->lst.handle = handle;
-            pos = _alBufAddData(_oalDevices, _OAL_DEVICE, d);
-
-            if (pos != UINT_MAX)
-            {
-                uint32_t id, devid;
-                id = _alBufPosToId(pos);
-                devid = _oalIdToDevice(id);
-                device = INT_TO_PTR(devid);
-            }
+            device = INT_TO_PTR(_oalDeviceAdd(d));
         }
     }
 
@@ -0,0 +1,301 @@
+/*
+ * Copyright (C) 2007-2016 by Erik Hofman.
+ * Copyright (C) 2007-2016 by Adalin B.V.
+ *
+ * This file is part of AeonWave-OpenAL.
+ *
+ *  AeonWave-OpenAL is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  AeonWave-OpenAL is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with AeonWave-OpenAL.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Asynchronous command queue.
+ *
+ * When enabled, the source setters for the attributes which change every
+ * frame only write a command record to a ring buffer of the context. A
+ * worker thread drains the ring, folds the commands into the shadow state
+ * of the sources and sends every source which changed to AeonWave once per
+ * pass. Repeated writes to the same source attribute between two passes
+ * therefore result in a single AeonWave call.
+ *
+ * The ring has free running head and tail counters on their own cache
+ * lines and stores the records in place, so queueing a command doesn't
+ * allocate memory.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#if HAVE_PTHREAD_H
+# include <pthread.h>
+#endif
+
+#include <aax/aax.h>
+#include <AL/al.h>
+
+#include <base/types.h>
+#include <base/atomic.h>
+#include <base/slab.h>
+
+#include "api.h"
+
+#define _OAL_COMMAND_QUEUE_SIZE		4096	/* must be a power of two */
+#define _OAL_COMMAND_QUEUE_MASK		(_OAL_COMMAND_QUEUE_SIZE-1)
+
+/* commands which aren't source updates have a source id of zero */
+#define _OAL_COMMAND_SUSPEND		1
+#define _OAL_COMMAND_PROCESS		2
+
+typedef struct
+{
+    ALuint source;
+    ALenum attrib;
+    float value[3];
+
+} _oalCommand;
+
+struct _oalCommandQueue_s
+{
+    unsigned int head;			/* written by the worker	 */
+    char pad1[SLAB_CACHE_LINE - sizeof(unsigned int)];
+    unsigned int tail;			/* written by the producers	 */
+    unsigned int lock;			/* serializes the producers	 */
+    char pad2[SLAB_CACHE_LINE - 2*sizeof(unsigned int)];
+
+    unsigned int done;			/* head after the last pass	 */
+    unsigned int sleeping;		/* set by the worker, see below	 */
+    char pad3[SLAB_CACHE_LINE - 2*sizeof(unsigned int)];
+
+    unsigned int running;
+    char suspend;			/* worker thread only		 */
+    void *context;
+#if HAVE_PTHREAD_H
+    pthread_t thread;
+    pthread_mutex_t mutex;		/* guards the wakeup condition	 */
+    pthread_cond_t cond;		/* signalled by the producers	 */
+#endif
+
+    _oalCommand cmd[_OAL_COMMAND_QUEUE_SIZE];
+};
+
+#if HAVE_PTHREAD_H
+static void *_oalCommandThread(void *);
+#endif
+static unsigned int _oalCommandDrain(_oalCommandQueue *);
+
+
+/*
+ * Create the queue and start it's worker thread if the application asked
+ * for ALC_UPDATE_QUEUED_AAX or if OPENAL_ENABLE_COMMAND_QUEUE is set.
+ */
+_oalCommandQueue *
+_oalCommandQueueCreate(void *context, char enable)
+{
+    _oalCommandQueue *rv = NULL;
+#if HAVE_PTHREAD_H
+    const char *env = getenv("OPENAL_ENABLE_COMMAND_QUEUE");
+
+    _AL_LOG(LOG_DEBUG, __FUNCTION__);
+
+    if (enable || (env && atoi(env)))
+    {
+        rv = calloc(1, sizeof(_oalCommandQueue));
+        if (rv)
+        {
+            rv->context = context;
+            rv->running = 1;
+            pthread_mutex_init(&rv->mutex, NULL);
+            pthread_cond_init(&rv->cond, NULL);
+            if (pthread_create(&rv->thread, NULL, _oalCommandThread, rv) != 0)
+            {
+                pthread_cond_destroy(&rv->cond);
+                pthread_mutex_destroy(&rv->mutex);
+                free(rv);
+                rv = NULL;
+            }
+        }
+    }
+#endif
+
+    return rv;
+}
+
+void
+_oalCommandQueueDestroy(_oalCommandQueue *queue)
+{
+    _AL_LOG(LOG_DEBUG, __FUNCTION__);
+
+    if (queue)
+    {
+#if HAVE_PTHREAD_H
+        pthread_mutex_lock(&queue->mutex);
+        _oal_atomic_store(&queue->running, 0);
+        pthread_cond_signal(&queue->cond);
+        pthread_mutex_unlock(&queue->mutex);
+
+        pthread_join(queue->thread, NULL);
+        pthread_cond_destroy(&queue->cond);
+        pthread_mutex_destroy(&queue->mutex);
+#else
+        _oal_atomic_store(&queue->running, 0);
+#endif
+        free(queue);
+    }
+}
+
+/*
+ * Add a command to the queue. This only blocks when the ring is full,
+ * until the worker thread has made room. The worker thread is only
+ * signalled when it went to sleep, a busy worker picks up the command
+ * without it.
+ */
+void
+_oalCommandQueuePush(_oalCommandQueue *queue, ALuint source, ALenum attrib,
+                     float v1, float v2, float v3)
+{
+    unsigned int expected = 0;
+    unsigned int tail;
+    _oalCommand *cmd;
+
+    while (!_oal_atomic_cas(&queue->lock, &expected, 1)) {
+        expected = 0;
+    }
+
+    tail = queue->tail;
+    while (tail - _oal_atomic_load(&queue->head) > _OAL_COMMAND_QUEUE_MASK) {
+        msecSleep(0);
+    }
+
+    cmd = &queue->cmd[tail & _OAL_COMMAND_QUEUE_MASK];
+    cmd->source = source;
+    cmd->attrib = attrib;
+    cmd->value[0] = v1;
+    cmd->value[1] = v2;
+    cmd->value[2] = v3;
+    _oal_atomic_store(&queue->tail, tail+1);
+
+    _oal_atomic_store(&queue->lock, 0);
+
+#if HAVE_PTHREAD_H
+    /* pairs with the fence of the worker, one of us sees the other */
+    _oal_atomic_fence();
+    if (_oal_atomic_load(&queue->sleeping))
+    {
+        pthread_mutex_lock(&queue->mutex);
+        pthread_cond_signal(&queue->cond);
+        pthread_mutex_unlock(&queue->mutex);
+    }
+#endif
+}
+
+/*
+ * Wait until the worker thread has applied all commands which were queued
+ * before the call. Used by calls which act on the sources right away, like
+ * alSourcePlay, so they see the position and gain set just before.
+ */
+void
+_oalCommandQueueFlush(_oalCommandQueue *queue)
+{
+    unsigned int tail = _oal_atomic_load(&queue->tail);
+
+    while ((int)(tail - _oal_atomic_load(&queue->done)) > 0) {
+        msecSleep(0);
+    }
+}
+
+void
+_oalCommandQueueSuspend(_oalCommandQueue *queue, char suspend)
+{
+    ALenum cmd = suspend ? _OAL_COMMAND_SUSPEND : _OAL_COMMAND_PROCESS;
+    _oalCommandQueuePush(queue, 0, cmd, 0.0f, 0.0f, 0.0f);
+}
+
+/* -------------------------------------------------------------------------- */
+
+#if HAVE_PTHREAD_H
+/*
+ * The worker sleeps on the condition variable while the queue is empty.
+ * It announces this in 'sleeping' before it checks the tail for the last
+ * time, and a producer checks 'sleeping' after it stored the tail. With a
+ * full fence on both sides either the worker sees the new command or the
+ * producer sees the worker sleeping and signals it, with the mutex held so
+ * the signal can't get lost before the wait.
+ */
+static void *
+_oalCommandThread(void *arg)
+{
+    _oalCommandQueue *queue = (_oalCommandQueue*)arg;
+
+    while (_oal_atomic_load(&queue->running))
+    {
+        if (!_oalCommandDrain(queue))
+        {
+            pthread_mutex_lock(&queue->mutex);
+            _oal_atomic_store(&queue->sleeping, 1);
+            _oal_atomic_fence();
+            while (_oal_atomic_load(&queue->running) &&
+                   _oal_atomic_load(&queue->tail) == queue->head)
+            {
+                pthread_cond_wait(&queue->cond, &queue->mutex);
+            }
+            _oal_atomic_store(&queue->sleeping, 0);
+            pthread_mutex_unlock(&queue->mutex);
+        }
+    }
+    _oalCommandDrain(queue);
+
+    return NULL;
+}
+#endif
+
+static unsigned int
+_oalCommandDrain(_oalCommandQueue *queue)
+{
+    unsigned int head = queue->head;
+    unsigned int tail = _oal_atomic_load(&queue->tail);
+    unsigned int rv = tail - head;
+
+    if (rv)
+    {
+        _alEpochEnter();
+        for (; head != tail; head++)
+        {
+            _oalCommand *cmd = &queue->cmd[head & _OAL_COMMAND_QUEUE_MASK];
+
+            if (cmd->source) {
+                _oalSourceCommand(queue->context, cmd->source, cmd->attrib,
+                                  cmd->value);
+            }
+            else if (cmd->attrib == _OAL_COMMAND_SUSPEND) {
+                queue->suspend = AL_TRUE;
+            }
+            else if (cmd->attrib == _OAL_COMMAND_PROCESS)
+            {
+                queue->suspend = AL_FALSE;
+                _oalUpdateSources(queue->context);
+            }
+            _oal_atomic_store(&queue->head, head+1);
+        }
+
+        if (!queue->suspend) {
+            _oalUpdateSources(queue->context);
+        }
+        _alEpochLeave();
+
+        _oal_atomic_store(&queue->done, tail);
+    }
+
+    return rv;
+}
@@ -26,6 +26,10 @@
 #include <assert.h>
 #endif
 #include <errno.h>
+#include <string.h>
+#if HAVE_PTHREAD_H
+# include <pthread.h>
+#endif
 #ifndef NDEBUG
 #if HAVE_UNISTD_H
 #  include <unistd.h>
@@ -39,6 +43,7 @@
 
 #include <base/types.h>
 #include <base/buffers.h>
+#include <base/atomic.h>
 
 #include "api.h"
 #include "aax_support.h"
@@ -50,48 +55,54 @@ const char *_oalContextErrorStrings[];
 static const _oalEnumValue_s _oalContextEnums[];
 static const char* _oalContextExtensions[];
 
-static unsigned int _oalCurrentContext;
+static uint32_t _oalCurrentContext;
+
+/*
+ * Context and device of the current context of a thread, which is either
+ * it's thread context (ALC_EXT_thread_local_context) or the process wide
+ * current context, as they were resolved the last time. The pointers are
+ * used without a table lookup as long as the current context didn't change
+ * and no context or device was destroyed since then, which is tracked by
+ * _oalCacheVersion.
+ */
+typedef struct
+{
+    uint32_t context;		/* thread context handle, zero if none */
+    uint32_t cached;		/* context handle of the cache	*/
+    unsigned int version;	/* _oalCacheVersion of the cache */
+    _alBufferData *dptr_ctx;	/* no reference is held		*/
+    _alBufferData *dptr_dev;
+
+} _oalThreadData;
+
+static THREAD_LOCAL _oalThreadData _oalThread;
+static unsigned int _oalCacheVersion = 0;
 
-static _alBufferData *_oalDeviceContextAdd(_oalDevice *);
+static _alBufferData *_oalDeviceContextAdd(_oalDevice *, uint32_t, uint32_t *);
+static void _oalDeviceContextsRemove(uint32_t);
+static _alBufferData *_oalGetCachedContext(char);
+static void _oalContextInvalidate(void);
 
 static _alBufferData *_oalFindContextByDeviceId(uint32_t);
 static void _oalSourcesCreate(void *);
 static void _oalFreeContext(void*);
+static void _oalFreeDevice(void*);
+static unsigned int _oalDeviceGetPoolStats(_oalDevice *, ALCenum);
+static unsigned int _oalDeviceGetAttributes(_oalDevice *, ALCint *);
+static ALCenum _oalDeviceGetState(uint32_t);
+static unsigned int _oalDeviceWait(_oalDevice *);
+static const ALCchar *_oalDeviceName(const ALCchar *);
 
 ALC_API ALCdevice * ALC_APIENTRY
 alcOpenDevice(const ALCchar *name)
 {
     ALCdevice *device = 0;
-    unsigned int pos = 0;
     aaxConfig handle;
 
     _AL_LOG(LOG_INFO, __FUNCTION__);
 
-    if (_oalDevices == 0)
-    {
-        pos = _alBufCreate(&_oalDevices, _OAL_DEVICE);
-        if (pos == UINT_MAX)
-        {
-            _oalContextSetError(ALC_OUT_OF_MEMORY);
-            return 0;
-        }
-    }
-
-    /**
-     * Treat "\0", "AeonWave" (and "DirectSound3D", "DirectSound"
-     * and "MMSYSTEM") as a request for the Default sound output
-     */
-    if (name && (name[0] == '\0' || !strcasecmp(name, "AeonWave")
-#if _WIN32
-        || !strcasecmp(name, "DirectSound3D")
-        || !strcasecmp(name, "DirectSound")
-        || !strcasecmp(name, "MMSYSTEM")
-#endif
-        ))
-    {
-        name = NULL;
-    }
-
+    _oalAAXDriverCacheStart();
+    name = _oalDeviceName(name);
     handle = aaxDriverOpenByName(name, AAX_MODE_WRITE_STEREO);
     if (handle != NULL)
     {
@@ -100,15 +111,60 @@ alcOpenDevice(const ALCchar *name)
         {
             d->sync = 0;
             d->lst.handle = handle;
-            pos = _alBufAddData(_oalDevices, _OAL_DEVICE, d);
-            if (pos != UINT_MAX)
-            {
-                uint32_t id, devid;
+            device = INT_TO_PTR(_oalDeviceAdd(d));
+        }
+    }
 
-                id = _alBufPosToId(pos);
-                devid = _oalIdToDevice(id);
-                device = INT_TO_PTR(devid);
-            }
+    return device;
+}
+
+static void *
+_oalDeviceOpenThread(void *device)
+{
+    _oalDevice *d = (_oalDevice *)device;
+
+    d->lst.handle = aaxDriverOpenByName(d->name, AAX_MODE_WRITE_STEREO);
+    _oal_atomic_store(&d->state, d->lst.handle ? _OAL_DEVICE_READY
+                                               : _OAL_DEVICE_FAILED);
+    return NULL;
+}
+
+/*
+ * ALC_AAX_async_open: return a device handle right away and open the
+ * driver in the background. Use ALC_DEVICE_STATE_AAX to find out whether
+ * the device is ready, any other use of the device waits until it is.
+ */
+ALC_API ALCdevice * ALC_APIENTRY
+alcOpenDeviceAsyncAAX(const ALCchar *name)
+{
+    ALCdevice *device = 0;
+    _oalDevice *d;
+
+    _AL_LOG(LOG_INFO, __FUNCTION__);
+
+    _oalAAXDriverCacheStart();
+    name = _oalDeviceName(name);
+    d = calloc(1, sizeof(_oalDevice));
+    if (d)
+    {
+        d->state = _OAL_DEVICE_OPENING;
+        if (name) d->name = strdup(name);
+
+        device = INT_TO_PTR(_oalDeviceAdd(d));
+        if (device)
+        {
+#if HAVE_PTHREAD_H
+            pthread_attr_t attr;
+            pthread_t thread;
+            int res;
+
+            pthread_attr_init(&attr);
+            pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+            res = pthread_create(&thread, &attr, _oalDeviceOpenThread, d);
+            pthread_attr_destroy(&attr);
+            if (res != 0)
+#endif
+                _oalDeviceOpenThread(d);
         }
     }
 
@@ -122,30 +178,44 @@ alcCloseDevice(ALCdevice *device)
 
     _AL_LOG(LOG_INFO, __FUNCTION__);
 
+    _oalLockDevices();
+    if (!_oalDevices)
+    {
+        _oalUnlockDevices();
+        return ALC_FALSE;
+    }
+
     id = _oalDeviceToId(device);
-    pos  = _alBufIdToPos(id);
+    pos = _alBufHandleToPos(_oalDevices, _OAL_DEVICE, id);
     if (pos != UINT_MAX)
     {
-        _oalDevice *d;
-        d = _alBufRemove(_oalDevices, _OAL_DEVICE, pos, AL_FALSE);
-        if (d)
-        {
-            d->current_context = UINT_MAX;
-            aaxMixerSetState(d->lst.handle, AAX_STOPPED);
+        _alBufferData *dptr;
 
-            aaxDriverClose(d->lst.handle);
-            aaxDriverDestroy(d->lst.handle);
-            _alBufErase(&d->contexts, _OAL_CONTEXT, _oalFreeContext);
-            _alBufErase(&d->buffers, _OAL_BUFFER, _oalFreeBuffer);
-            free(d);
+        _oalContextInvalidate();
 
-            if (_alBufGetNumNoLock(_oalDevices, _OAL_DEVICE) == 0) {
-                _alBufErase(&_oalDevices, _OAL_DEVICE, free);
+        /* our own reference makes sure the device is freed unlocked */
+        dptr = _alBufGet(_oalDevices, _OAL_DEVICE, pos);
+        if (dptr &&
+            _alBufRemoveRelease(_oalDevices, _OAL_DEVICE, pos, _oalFreeDevice))
+        {
+            _oalDeviceContextsRemove(id);
+            if (_alBufGetNumNoLock(_oalDevices, _OAL_DEVICE) == 0)
+            {
+                _alBufErase(&_oalContexts, _OAL_CONTEXT, _oalFreeContext);
+                _alBufErase(&_oalDevices, _OAL_DEVICE, _oalFreeDevice);
+                _alBufDumpCounters(_al_id_s, _OAL_MAX_ID);
             }
+            _oalUnlockDevices();
+
+            /* other threads might still use it, the last one frees it */
+            _alBufReleaseData(dptr, _OAL_DEVICE);
 
             return ALC_TRUE;
         }
+        _alBufReleaseData(dptr, _OAL_DEVICE);
     }
+    _oalUnlockDevices();
+
     return ALC_FALSE;
 }
 
@@ -154,6 +224,7 @@ alcCreateContext(const ALCdevice *device, const ALCint *attributes)
 {
     _alBufferData *dptr_ctx = 0;
     enum aaxFormat format;
+    char queued = AL_FALSE;
     aaxConfig handle;
     uint32_t id = 0;
     _oalContext *ctx;
@@ -163,12 +234,9 @@ alcCreateContext(const ALCdevice *device, const ALCint *attributes)
     _AL_LOG(LOG_INFO, __FUNCTION__);
 
     d = _oalFindDeviceById(_oalDeviceToId(device));
-    dptr_ctx = _oalDeviceContextAdd(d);
+    dptr_ctx = _oalDeviceContextAdd(d, _oalDeviceToId(device), &id);
     if (dptr_ctx)
     {
-        id = _oalDeviceMask(device);
-        id |= _alBufPosToId(d->current_context);
-
         ctx = _alBufGetDataPtr(dptr_ctx);
         ctx->sync = d->sync;
 
@@ -196,10 +264,49 @@ alcCreateContext(const ALCdevice *device, const ALCint *attributes)
                 case ALC_REFRESH:
                      aaxMixerSetSetup(handle, AAX_REFRESH_RATE, (unsigned)attributes[n]);
                     break;
+                /* ALC_AAX_context_hints */
+                case ALC_MIXER_THREADS_AAX:
+                    ctx->mixer_threads = _MAX(attributes[n], 0);
+                    break;
+                case ALC_PERIOD_SIZE_AAX:
+                    ctx->period_size = _MAX(attributes[n], 0);
+                    break;
+                case ALC_UPDATE_MODE_AAX:
+                    if (attributes[n] == ALC_UPDATE_QUEUED_AAX) {
+                        queued = AL_TRUE;
+                    } else if (attributes[n] != ALC_UPDATE_IMMEDIATE_AAX) {
+                        _oalContextSetError(ALC_INVALID_VALUE);
+                    }
+                    break;
+                case ALC_SOURCE_PREALLOC_AAX:
+                    ctx->source_prealloc = _MAX(attributes[n], 0);
+                    break;
+                case ALC_BUFFER_PREALLOC_AAX:
+                    ctx->buffer_prealloc = _MAX(attributes[n], 0);
+                    break;
+                case ALC_MAX_VOICES_AAX:
+                    ctx->max_voices = _MAX(attributes[n], 0);
+                    break;
                 default:
                     _oalContextSetError(ALC_INVALID_VALUE);
                 }
             }
+
+            /* the period size is relative to the final mixer frequency */
+            if (ctx->period_size)
+            {
+                unsigned int freq = aaxMixerGetSetup(handle, AAX_FREQUENCY);
+                unsigned int refresh = _MAX(freq/ctx->period_size, 1);
+                aaxMixerSetSetup(handle, AAX_REFRESH_RATE, refresh);
+            }
+        }
+
+        /* by default every emitter the mixer can handle is a voice */
+        if (!ctx->max_voices)
+        {
+            ctx->max_voices = aaxMixerGetSetup(NULL, AAX_MONO_EMITTERS)
+                              + aaxMixerGetSetup(NULL, AAX_STEREO_EMITTERS);
+            if (!ctx->max_voices) ctx->max_voices = UINT_MAX;
         }
 
         aaxMixerSetState(handle, AAX_INITIALIZED);
@@ -212,6 +319,26 @@ alcCreateContext(const ALCdevice *device, const ALCint *attributes)
 
         _oalStateCreate(handle, ctx);
         _oalSourcesCreate(ctx);
+        ctx->queue = _oalCommandQueueCreate(ctx, queued);
+
+        if (ctx->source_prealloc && ctx->sources)
+        {
+            unsigned int num = ctx->source_prealloc;
+            if (!_alSlabReserve(ctx->slab, num) ||
+                !_alBufReserve(ctx->sources, _OAL_SOURCE, num) ||
+                _oalEmitterPoolCreate(ctx, num) < num)
+            {
+                _oalContextSetError(ALC_OUT_OF_MEMORY);
+            }
+        }
+
+        if (ctx->buffer_prealloc)
+        {
+            _alBuffers *bufs = _oalGetBuffers(d);
+            if (!bufs || !_alBufReserve(bufs, _OAL_BUFFER, ctx->buffer_prealloc)) {
+                _oalContextSetError(ALC_OUT_OF_MEMORY);
+            }
+        }
 
         _alBufReleaseData(dptr_ctx, _OAL_CONTEXT);
     }
@@ -228,26 +355,25 @@ alcMakeContextCurrent(ALCcontext *context)
     unsigned int pos = UINT_MAX;
 
     _AL_LOG(LOG_INFO, __FUNCTION__);
- 
+
+    /* ALC_EXT_thread_local_context: release the context of this thread */
+    _oalThread.context = 0;
+
     if (context)
     {
-        unsigned int id;
-
-        id = _oalDeviceToId(context);
-        pos = _alBufIdToPos(id);
-        if (pos != UINT_MAX)
+        uint32_t id = _oalContextToId(context);
+        _alBufferData *dptr_ctx = _oalFindContextById(id);
+        if (dptr_ctx)
         {
-            _oalDevice *dev = _oalFindDeviceById(id);
+            _oalContext *ctx = _alBufGetDataPtr(dptr_ctx);
+            _oalDevice *dev = _oalFindDeviceById(ctx->device);
             if (dev)
             {
-                id = _oalContextMask(context);
-                pos = _alBufIdToPos(id);
-                if (pos != UINT_MAX)
-                {
-                    _oalCurrentContext = (size_t)context;
-                    dev->current_context = _alBufIdToPos(id);
-                }
+                _oal_atomic_store(&_oalCurrentContext, id);
+                dev->current_context = id;
+                pos = 0;
             }
+            _alBufReleaseData(dptr_ctx, _OAL_CONTEXT);
         }
         else {
             _oalContextSetError(ALC_INVALID_CONTEXT);
@@ -255,117 +381,229 @@ alcMakeContextCurrent(ALCcontext *context)
     }
     else if (_oalDevices)
     {
-        unsigned int num, i;
+        unsigned int max, i;
 
-        num = _alBufGetNum(_oalDevices, _OAL_DEVICE);
-        for (i=0; i<num; i++)
+        max = _alBufGetMaxNum(_oalDevices, _OAL_DEVICE);
+        for (i=0; i<max; i++)
         {
             _alBufferData *dptr;
 
-            dptr =  _alBufGet(_oalDevices, _OAL_DEVICE, i);
+            dptr =  _alBufGetNoLock(_oalDevices, _OAL_DEVICE, i);
             if (dptr)
             {
-                _oalDevice *dev;
-
-                dev = _alBufGetDataPtr(dptr);
-
-                dev->current_context =  UINT_MAX;
-                _oalCurrentContext = UINT_MAX;
-
-                _alBufReleaseData(dptr, _OAL_DEVICE);
+                _oalDevice *dev = _alBufGetDataPtr(dptr);
+                dev->current_context = 0;
             }
         }
         _alBufReleaseNum(_oalDevices, _OAL_DEVICE);
 
+        _oal_atomic_store(&_oalCurrentContext, 0);
         pos = 0;
     }
 
     return (pos == UINT_MAX) ? AL_FALSE : AL_TRUE;
 }
 
+/*
+ * Send all source and listener updates which were made since the context
+ * was suspended to AeonWave in one go, so the mixer picks them up as one
+ * consistent scene.
+ */
 ALC_API void ALC_APIENTRY
 alcProcessContext(ALCcontext *context)
 {
-#if 0
-    _oalContext *ctx;
+    _alBufferData *dptr;
     uint32_t id;
 
-    id = _oalContextMask(context);
-    ctx = _oalFindContextById(id);
-    if (ctx)
-        ctx->suspend = ALC_FALSE;
-#if 0
-    else
+    _AL_LOG(LOG_INFO, __FUNCTION__);
+
+    id = _oalContextToId(context);
+    dptr = _oalFindContextById(id);
+    if (dptr)
+    {
+        _oalContext *ctx = _alBufGetDataPtr(dptr);
+        _oalDevice *dev = (_oalDevice *)ctx->parent_device;
+
+        if (ctx->suspend)
+        {
+            ctx->suspend = ALC_FALSE;
+            if (ctx->queue) {
+                _oalCommandQueueSuspend(ctx->queue, AL_FALSE);
+            } else {
+                _oalUpdateSources(ctx);
+            }
+            _oalUpdateListener(&dev->lst);
+        }
+        _oalVoicesUpdate(ctx, AL_TRUE);
+        _alBufReleaseData(dptr, _OAL_CONTEXT);
+    }
+    else {
         _oalContextSetError(ALC_INVALID_CONTEXT);
-#endif
-#endif
+    }
 }
 
+/*
+ * Hold back the position, direction, velocity, gain and pitch updates of
+ * the sources and the listener until alcProcessContext gets called.
+ */
 ALC_API void ALC_APIENTRY
 alcSuspendContext(ALCcontext *context)
 {
-#if 0
-    _oalContext *ctx;
+    _alBufferData *dptr;
     uint32_t id;
 
-    id = _oalContextMask(context);
-    ctx = _oalFindContextById(id);
-    if (ctx)
+    _AL_LOG(LOG_INFO, __FUNCTION__);
+
+    id = _oalContextToId(context);
+    dptr = _oalFindContextById(id);
+    if (dptr)
+    {
+        _oalContext *ctx = _alBufGetDataPtr(dptr);
+        if (!ctx->suspend && ctx->queue) {
+            _oalCommandQueueSuspend(ctx->queue, AL_TRUE);
+        }
         ctx->suspend = ALC_TRUE;
-    else
+        _alBufReleaseData(dptr, _OAL_CONTEXT);
+    }
+    else {
         _oalContextSetError(ALC_INVALID_CONTEXT);
-#endif
+    }
 }
 
 ALC_API void ALC_APIENTRY
 alcDestroyContext(ALCcontext *context)
 {
-    _oalDevice *dev;
+    unsigned int pos = UINT_MAX;
     uint32_t id;
 
     _AL_LOG(LOG_INFO, __FUNCTION__);
 
-    id = _oalDeviceToId(context);
-    dev = _oalFindDeviceById(id);
-    if (dev)
+    id = _oalContextToId(context);
+
+    _oalLockDevices();
+    if (_oalContexts) {
+        pos = _alBufHandleToPos(_oalContexts, _OAL_CONTEXT, id);
+    }
+    if (pos != UINT_MAX)
     {
-        unsigned int pos;
+        _alBufferData *dptr;
 
-        id = _oalContextMask(context);
-        pos = _alBufIdToPos(id);
-        if (pos != UINT_MAX)
-        {
-            _oalContext *ctx;
+        _oalContextInvalidate();
 
-            if (dev->current_context == pos) {
-                dev->current_context = UINT_MAX;
+        /* our own reference keeps the context alive until we're done */
+        dptr = _alBufGet(_oalContexts, _OAL_CONTEXT, pos);
+        if (dptr &&
+            !_alBufRemoveRelease(_oalContexts, _OAL_CONTEXT, pos,
+                                 _oalFreeContext))
+        {
+            _alBufReleaseData(dptr, _OAL_CONTEXT);
+            dptr = NULL;
+        }
+        _oalUnlockDevices();
+        if (dptr)
+        {
+            _oalContext *ctx = _alBufGetDataPtr(dptr);
+            _oalDevice *dev = _oalFindDeviceById(ctx->device);
+            if (dev)
+            {
+                if (dev->current_context == id) {
+                    dev->current_context = 0;
+                }
+                aaxMixerSetState(dev->lst.handle, AAX_STOPPED);
+            }
+            if (_oalCurrentContext == id) {
+                _oal_atomic_store(&_oalCurrentContext, 0);
+            }
+            if (_oalThread.context == id) {
+                _oalThread.context = 0;
             }
-            aaxMixerSetState(dev->lst.handle, AAX_STOPPED);
 
-            ctx = _alBufRemove(dev->contexts, _OAL_CONTEXT, pos, AL_FALSE);
-            if (ctx) _oalFreeContext(ctx);
-            return;  
+            /* other threads might still use it, the last one frees it */
+            _alBufReleaseData(dptr, _OAL_CONTEXT);
+            return;
         }
     }
+    else {
+        _oalUnlockDevices();
+    }
     _oalContextSetError(ALC_INVALID_CONTEXT);
 }
 
 ALC_API ALCcontext * ALC_APIENTRY
 alcGetCurrentContext(void)
 {
-    return INT_TO_PTR(_oalCurrentContext);
+    uint32_t id = _oalThread.context;
+    return INT_TO_PTR(id ? id : _oalCurrentContext);
+}
+
+ALC_API ALCboolean ALCEXT_APIENTRY
+alcSetThreadContext(ALCcontext *context)
+{
+    uint32_t id = 0;
+
+    _AL_LOG(LOG_INFO, __FUNCTION__);
+
+    if (context)
+    {
+        _alBufferData *dptr_ctx;
+
+        id = _oalContextToId(context);
+        dptr_ctx = _oalFindContextById(id);
+        if (!dptr_ctx)
+        {
+            _oalContextSetError(ALC_INVALID_CONTEXT);
+            return ALC_FALSE;
+        }
+        _alBufReleaseData(dptr_ctx, _OAL_CONTEXT);
+    }
+
+    _oalThread.context = id;
+    _oalThread.cached = 0;
+
+    return ALC_TRUE;
+}
+
+ALC_API ALCcontext* ALCEXT_APIENTRY
+alcGetThreadContext(void)
+{
+    uint32_t id = _oalThread.context;
+
+    if (id)
+    {
+        _alBuffers *contexts;
+        unsigned int pos = UINT_MAX;
+
+        _alEpochEnter();
+        contexts = _oal_atomic_load(&_oalContexts);
+        if (contexts) {
+            pos = _alBufHandleToPos(contexts, _OAL_CONTEXT, id);
+        }
+        _alEpochLeave();
+
+        if (pos == UINT_MAX)
+        {
+            /* the context was destroyed by another thread */
+            _oalThread.context = id = 0;
+        }
+    }
+
+    return INT_TO_PTR(id);
 }
 
 ALC_API ALCdevice * ALC_APIENTRY
 alcGetContextsDevice(ALCcontext *context)
 {
-    unsigned int ctx_id, dev_id = 0;
+    _alBufferData *dptr_ctx;
+    uint32_t dev_id = 0;
 
     _AL_LOG(LOG_INFO, __FUNCTION__);
 
-    ctx_id = _oalContextMask(context);
-    if (ctx_id) {
-        dev_id = _oalDeviceMask(context);
+    dptr_ctx = _oalFindContextById(_oalContextToId(context));
+    if (dptr_ctx)
+    {
+        _oalContext *ctx = _alBufGetDataPtr(dptr_ctx);
+        dev_id = ctx->device;
+        _alBufReleaseData(dptr_ctx, _OAL_CONTEXT);
     }
 
     return INT_TO_PTR(dev_id);
@@ -436,6 +674,7 @@ alcIsExtensionPresent(const ALCdevice *device,  const ALCchar *name)
     unsigned int i;
     const char *e;
 
+    _oalAAXDriverCacheStart();
     if (!name)
     {
         _oalContextSetError(ALC_INVALID_VALUE);
@@ -497,6 +736,7 @@ alcGetString(ALCdevice *device, ALCenum attrib)
     unsigned int id;
     char *retstr;
 
+    _oalAAXDriverCacheStart();
     id = _oalDeviceToId(device);
     dev = _oalFindDeviceById(id);
     retstr = "";
@@ -549,27 +789,11 @@ alcGetString(ALCdevice *device, ALCenum attrib)
         }
         break;
     case ALC_CAPTURE_DEFAULT_DEVICE_SPECIFIER:
-        {
-            static char renderer[128];
-            aaxConfig config = aaxDriverGetByName(NULL, AAX_MODE_READ);
-            retstr = (char *)aaxDriverGetSetup(config, AAX_RENDERER_STRING);
-            snprintf(renderer, 128, "%s", retstr);
-            renderer[127] = '\0';
-            aaxDriverDestroy(config);
-            retstr = renderer;
-        }
+        retstr = (char *)_oalAAXGetDefaultDriver(AAX_MODE_READ);
         break;
     case ALC_DEFAULT_ALL_DEVICES_SPECIFIER:
     case ALC_DEFAULT_DEVICE_SPECIFIER:
-        {
-            static char renderer[128];
-            aaxConfig config = aaxDriverGetByName(NULL, AAX_MODE_WRITE_STEREO);
-            retstr = (char *)aaxDriverGetSetup(config, AAX_RENDERER_STRING);
-            snprintf(renderer, 128, "%s", retstr);
-            renderer[127] = '\0';
-            aaxDriverDestroy(config);
-            retstr = renderer;
-        }
+        retstr = (char *)_oalAAXGetDefaultDriver(AAX_MODE_WRITE_STEREO);
         break;
     default:
         _oalContextSetError(ALC_INVALID_ENUM);
@@ -590,8 +814,9 @@ alcGetString(ALCdevice *device, ALCenum attrib)
 /*-------------------------------------------------------------------------- */
 
 _alBuffers *_oalDevices = 0;
+_alBuffers *_oalContexts = 0;
 
-static unsigned int _oalCurrentContext = UINT_MAX;
+static uint32_t _oalCurrentContext = 0;
 
 const int _oalContextVersion[2] = {1, 1};
 const int _oalEFXVersion[2] = {1, 0};
@@ -600,6 +825,8 @@ static const char* _oalContextExtensions[] =
 {
   "ALC_enumeration_EXT",
   "ALC_enumerate_all_EXT",
+  "ALC_EXT_thread_local_context",
+  "ALC_AAX_async_open",
 
   NULL				/* always last */
 };
@@ -645,6 +872,24 @@ static const _oalEnumValue_s _oalContextEnums[] =
   {"ALC_FREQUENCY_AAX",			ALC_FREQUENCY_AAX},
   {"ALC_BITS_AAX",			ALC_BITS_AAX},
   {"ALC_CHANNELS_AAX",			ALC_CHANNELS_AAX},
+  {"ALC_SOURCE_POOL_SIZE_AAX",		ALC_SOURCE_POOL_SIZE_AAX},
+  {"ALC_SOURCE_POOL_USED_AAX",		ALC_SOURCE_POOL_USED_AAX},
+  {"ALC_SOURCE_POOL_PEAK_AAX",		ALC_SOURCE_POOL_PEAK_AAX},
+  {"ALC_BUFFER_POOL_SIZE_AAX",		ALC_BUFFER_POOL_SIZE_AAX},
+  {"ALC_BUFFER_POOL_USED_AAX",		ALC_BUFFER_POOL_USED_AAX},
+  {"ALC_BUFFER_POOL_PEAK_AAX",		ALC_BUFFER_POOL_PEAK_AAX},
+  {"ALC_MIXER_THREADS_AAX",		ALC_MIXER_THREADS_AAX},
+  {"ALC_PERIOD_SIZE_AAX",		ALC_PERIOD_SIZE_AAX},
+  {"ALC_UPDATE_MODE_AAX",		ALC_UPDATE_MODE_AAX},
+  {"ALC_SOURCE_PREALLOC_AAX",		ALC_SOURCE_PREALLOC_AAX},
+  {"ALC_BUFFER_PREALLOC_AAX",		ALC_BUFFER_PREALLOC_AAX},
+  {"ALC_MAX_VOICES_AAX",		ALC_MAX_VOICES_AAX},
+  {"ALC_DEVICE_STATE_AAX",		ALC_DEVICE_STATE_AAX},
+  {"ALC_DEVICE_OPENING_AAX",		ALC_DEVICE_OPENING_AAX},
+  {"ALC_DEVICE_READY_AAX",		ALC_DEVICE_READY_AAX},
+  {"ALC_DEVICE_FAILED_AAX",		ALC_DEVICE_FAILED_AAX},
+  {"ALC_UPDATE_IMMEDIATE_AAX",		ALC_UPDATE_IMMEDIATE_AAX},
+  {"ALC_UPDATE_QUEUED_AAX",		ALC_UPDATE_QUEUED_AAX},
 
   {"ALC_EFX_MAJOR_VERSION",		ALC_EFX_MAJOR_VERSION},
   {"ALC_EFX_MINOR_VERSION",		ALC_EFX_MINOR_VERSION},
@@ -666,8 +911,8 @@ const char *_oalContextErrorStrings[] =
 ALCenum
 __oalContextSetErrorNormal(ALCenum error)
 {
-    static char been_here_before = 0;
-    static ALCenum _ret = ALC_NO_ERROR;
+    static THREAD_LOCAL char been_here_before = 0;
+    static THREAD_LOCAL ALCenum _ret = ALC_NO_ERROR;
     ALCenum ret = _ret;
 
     if (!been_here_before)
@@ -715,55 +960,109 @@ __oalContextSetErrorReport(ALCenum error, char *file, int line)
 _alBufferData *
 _oalGetCurrentDevice()
 {
-    _alBufferData *dptr_dev = 0;
-
     _AL_LOG(LOG_DEBUG, __FUNCTION__);
 
-    if (_oalCurrentContext != UINT_MAX)
-    {
-        unsigned int dev_pos;
-
-        dev_pos = _alBufIdToPos(_oalDeviceToId(_oalCurrentContext));
-        if (dev_pos != UINT_MAX) {
-            dptr_dev = _alBufGet(_oalDevices, _OAL_DEVICE, dev_pos);
-        }
-    }
-
-    return dptr_dev;
+    return _oalGetCachedContext(AL_TRUE);
 }
 
 _alBufferData *
 _oalGetCurrentContext()
 {
-    _alBufferData *dptr_ctx = 0;
-
     _AL_LOG(LOG_DEBUG, __FUNCTION__);
 
-    if (_oalCurrentContext != UINT_MAX)
+    return _oalGetCachedContext(AL_FALSE);
+}
+
+/**
+ * Get a reference to the current context of the calling thread or, if
+ * 'device' is true, to it's device. Only a cache miss needs to lookup
+ * the handles.
+ **/
+static _alBufferData *
+_oalGetCachedContext(char device)
+{
+    _oalThreadData *t = &_oalThread;
+    _alBufferData *rv = NULL;
+    unsigned int version;
+    uint32_t id;
+
+    id = t->context;
+    if (!id) id = _oal_atomic_load(&_oalCurrentContext);
+    if (!id) return NULL;
+
+    /*
+     * The version is read inside the epoch section. Destroying a context or
+     * device increments the version before the object is removed, so if the
+     * cache is current nothing it points to can be freed before we leave.
+     */
+    _alEpochEnter();
+    version = _oal_atomic_load(&_oalCacheVersion);
+    if (t->cached == id && t->version == version)
     {
-        unsigned int ctx_pos;
+        rv = _alBufAcquireData(device ? t->dptr_dev : t->dptr_ctx,
+                               device ? _OAL_DEVICE : _OAL_CONTEXT);
+    }
+    _alEpochLeave();
 
-        ctx_pos = _alBufIdToPos(_oalContextMask(_oalCurrentContext));
-        if (ctx_pos != UINT_MAX)
+    if (!rv)
+    {
+        _alBufferData *dptr_ctx, *dptr_dev = NULL;
+
+        dptr_ctx = _oalFindContextById(id);
+        if (dptr_ctx)
         {
-            _alBufferData *dptr_dev = _oalGetCurrentDevice();
-            if (dptr_dev)
+            _oalContext *ctx = _alBufGetDataPtr(dptr_ctx);
+            _alBuffers *devices;
+            unsigned int pos;
+
+            _alEpochEnter();
+            devices = _oal_atomic_load(&_oalDevices);
+            if (devices)
             {
-                _oalDevice *dev = _alBufGetDataPtr(dptr_dev);
-                dptr_ctx =_alBufGet(dev->contexts,_OAL_CONTEXT, ctx_pos);
-                _alBufReleaseData(dptr_dev, _OAL_DEVICE);
+                pos = _alBufHandleToPos(devices, _OAL_DEVICE, ctx->device);
+                if (pos != UINT_MAX) {
+                    dptr_dev = _alBufGet(devices, _OAL_DEVICE, pos);
+                }
             }
+            _alEpochLeave();
+        }
+
+        t->cached = dptr_ctx ? id : 0;
+        t->version = version;
+        t->dptr_ctx = dptr_ctx;
+        t->dptr_dev = dptr_dev;
+
+        if (device)
+        {
+            rv = dptr_dev;
+            if (dptr_ctx) _alBufReleaseData(dptr_ctx, _OAL_CONTEXT);
+        }
+        else
+        {
+            rv = dptr_ctx;
+            if (dptr_dev) _alBufReleaseData(dptr_dev, _OAL_DEVICE);
         }
     }
 
-    return dptr_ctx;
+    return rv;
+}
+
+/**
+ * Make all cached context and device pointers invalid, needs to be called
+ * before a context or device gets removed.
+ **/
+static void
+_oalContextInvalidate()
+{
+    _oal_atomic_add(&_oalCacheVersion, 1);
 }
 
 /**
- * Add a context to a device
+ * Add a context to a device, the handle of the new context is returned
+ * in 'id'.
  **/
 static _alBufferData *
-_oalDeviceContextAdd(_oalDevice *d)
+_oalDeviceContextAdd(_oalDevice *d, uint32_t dev_id, uint32_t *id)
 {
     _alBufferData *dptr = 0;
     unsigned int r = 0;
@@ -772,8 +1071,9 @@ _oalDeviceContextAdd(_oalDevice *d)
 
     if (!d) return 0;
 
-    if (d->contexts == 0) {
-        r = _alBufCreate(&d->contexts, _OAL_CONTEXT);
+    _oalLockDevices();
+    if (_oalContexts == 0) {
+        r = _alBufCreateMode(&_oalContexts, _OAL_CONTEXT, BUFFER_HANDLES);
     }
 
     if (r != UINT_MAX)
@@ -781,72 +1081,314 @@ _oalDeviceContextAdd(_oalDevice *d)
         _oalContext *ctx = calloc(1, sizeof(_oalContext));
         if (ctx)
         {
+            unsigned int pos;
+
             ctx->parent_device = d;
+            ctx->device = dev_id;
 
-            r = _alBufAddData(d->contexts, _OAL_CONTEXT, ctx);
+            /* the device is freed after the last of it's contexts */
+            pos = _alBufHandleToPos(_oalDevices, _OAL_DEVICE, dev_id);
+            ctx->dptr_dev = _alBufGet(_oalDevices, _OAL_DEVICE, pos);
+            if (ctx->dptr_dev) {
+                r = _alBufAddData(_oalContexts, _OAL_CONTEXT, ctx);
+            } else {
+                r = UINT_MAX;
+            }
             if (r != UINT_MAX)
             {
-                d->current_context = r;
-                dptr = _alBufGet(d->contexts, _OAL_CONTEXT, r);
+                *id = _alBufPosToHandle(_oalContexts, _OAL_CONTEXT, r);
+                d->current_context = *id;
+                dptr = _alBufGet(_oalContexts, _OAL_CONTEXT, r);
             }
         }
+        _oalUnlockDevices();
 
         if (!dptr)
         {
             _oalContextSetError(ALC_OUT_OF_MEMORY);
-            if (ctx) free(ctx);
+            if (ctx)
+            {
+                _alBufReleaseData(ctx->dptr_dev, _OAL_DEVICE);
+                free(ctx);
+            }
         }
     } 
-    else {
+    else
+    {
+        _oalUnlockDevices();
         _oalContextSetError(ALC_OUT_OF_MEMORY);
     }
 
     return dptr;
 }
 
+/**
+ * Add a device to the device array, create the array if required.
+ * Returns the handle of the device or zero upon failure in which case
+ * the device is destroyed.
+ **/
+unsigned int
+_oalDeviceAdd(_oalDevice *d)
+{
+    unsigned int pos = 0;
+    uint32_t rv = 0;
+
+    _AL_LOG(LOG_DEBUG, __FUNCTION__);
+
+    _oalLockDevices();
+    if (_oalDevices == 0) {
+        pos = _alBufCreateMode(&_oalDevices, _OAL_DEVICE, BUFFER_HANDLES);
+    }
+    if (pos != UINT_MAX) {
+        pos = _alBufAddData(_oalDevices, _OAL_DEVICE, d);
+    }
+    if (pos != UINT_MAX) {
+        rv = _alBufPosToHandle(_oalDevices, _OAL_DEVICE, pos);
+    }
+    _oalUnlockDevices();
+
+    if (!rv)
+    {
+        _oalContextSetError(ALC_OUT_OF_MEMORY);
+        if (d->lst.handle) aaxDriverDestroy(d->lst.handle);
+        free(d->name);
+        free(d);
+    }
+
+    return rv;
+}
+
+/*
+ * Serializes adding and removing devices and contexts. Lookups don't need
+ * it, they only use the lock-free handle functions.
+ */
+static unsigned int _oalDevicesLock = 0;
+
+void
+_oalLockDevices()
+{
+    unsigned int expected = 0;
+    while (!_oal_atomic_cas(&_oalDevicesLock, &expected, 1))
+    {
+        expected = 0;
+        msecSleep(0);
+    }
+}
+
+void
+_oalUnlockDevices()
+{
+    _oal_atomic_store(&_oalDevicesLock, 0);
+}
+
+/**
+ * Remove all contexts of a device
+ **/
+static void
+_oalDeviceContextsRemove(uint32_t dev_id)
+{
+    unsigned int max, i;
+
+    _AL_LOG(LOG_DEBUG, __FUNCTION__);
+
+    if (!_oalContexts) return;
+
+    max = _alBufGetMaxNumNoLock(_oalContexts, _OAL_CONTEXT);
+    for (i=0; i<max; i++)
+    {
+        _alBufferData *dptr;
+
+        dptr = _alBufGet(_oalContexts, _OAL_CONTEXT, i);
+        if (dptr)
+        {
+            _oalContext *ctx = _alBufGetDataPtr(dptr);
+            char remove = (ctx->device == dev_id);
+
+            _alBufReleaseData(dptr, _OAL_CONTEXT);
+            if (remove)
+            {
+                uint32_t id = _alBufPosToHandle(_oalContexts, _OAL_CONTEXT, i);
+                if (_oalCurrentContext == id) {
+                    _oal_atomic_store(&_oalCurrentContext, 0);
+                }
+
+                _oalContextInvalidate();
+                _alBufRemoveRelease(_oalContexts, _OAL_CONTEXT, i,
+                                    _oalFreeContext);
+            }
+        }
+    }
+}
+
 _oalDevice *
 _oalFindDeviceById(uint32_t id)
 {
+    _alBuffers *devices;
     _oalDevice *dev = 0;
-    unsigned int i, num;
 
     _AL_LOG(LOG_DEBUG, __FUNCTION__);
 
-    i = _alBufIdToPos(id);
-    if (i != UINT_MAX)
+    /* the table is freed through the epoch when the last device closes */
+    _alEpochEnter();
+    devices = _oal_atomic_load(&_oalDevices);
+    if (devices)
     {
-        num = _alBufGetNum(_oalDevices, _OAL_DEVICE);
-        if (i < num)
+        unsigned int pos = _alBufHandleToPos(devices, _OAL_DEVICE, id);
+        if (pos != UINT_MAX)
         {
             _alBufferData *dptr;
-            dptr = _alBufGetNoLock(_oalDevices, _OAL_DEVICE, i);
+            dptr = _alBufGetNoLock(devices, _OAL_DEVICE, pos);
             dev = _alBufGetDataPtr(dptr);
         }
-        _alBufReleaseNum(_oalDevices, _OAL_DEVICE);
+    }
+    _alEpochLeave();
+
+    if (dev && _oalDeviceWait(dev) != _OAL_DEVICE_READY) {
+        dev = NULL;
     }
 
     return dev;
 }
 
+/*
+ * Like _oalFindDeviceById but the device stays valid, even if another
+ * thread closes it, until the reference is released.
+ */
+_alBufferData *
+_oalGetDeviceById(uint32_t id)
+{
+    _alBufferData *dptr = NULL;
+    _alBuffers *devices;
+
+    _AL_LOG(LOG_DEBUG, __FUNCTION__);
+
+    _alEpochEnter();
+    devices = _oal_atomic_load(&_oalDevices);
+    if (devices)
+    {
+        unsigned int pos = _alBufHandleToPos(devices, _OAL_DEVICE, id);
+        if (pos != UINT_MAX) {
+            dptr = _alBufGet(devices, _OAL_DEVICE, pos);
+        }
+    }
+    _alEpochLeave();
+
+    if (dptr && _oalDeviceWait(_alBufGetDataPtr(dptr)) != _OAL_DEVICE_READY)
+    {
+        _alBufReleaseData(dptr, _OAL_DEVICE);
+        dptr = NULL;
+    }
+
+    return dptr;
+}
+
+/* Wait for the driver of a device opened by alcOpenDeviceAsyncAAX. */
+static unsigned int
+_oalDeviceWait(_oalDevice *dev)
+{
+    unsigned int state;
+
+    while ((state = _oal_atomic_load(&dev->state)) == _OAL_DEVICE_OPENING) {
+        msecSleep(1);
+    }
+
+    return state;
+}
+
+static ALCenum
+_oalDeviceGetState(uint32_t id)
+{
+    ALCenum rv = ALC_DEVICE_FAILED_AAX;
+    unsigned int pos = UINT_MAX;
+    _alBuffers *devices;
+
+    _alEpochEnter();
+    devices = _oal_atomic_load(&_oalDevices);
+    if (devices) {
+        pos = _alBufHandleToPos(devices, _OAL_DEVICE, id);
+    }
+
+    if (pos != UINT_MAX)
+    {
+        _alBufferData *dptr = _alBufGetNoLock(devices, _OAL_DEVICE, pos);
+        _oalDevice *dev = dptr ? _alBufGetDataPtr(dptr) : NULL;
+        if (dev)
+        {
+            switch (_oal_atomic_load(&dev->state))
+            {
+            case _OAL_DEVICE_READY:
+                rv = ALC_DEVICE_READY_AAX;
+                break;
+            case _OAL_DEVICE_OPENING:
+                rv = ALC_DEVICE_OPENING_AAX;
+                break;
+            default:
+                break;
+            }
+        }
+    }
+    else {
+        _oalContextSetError(ALC_INVALID_DEVICE);
+    }
+    _alEpochLeave();
+
+    return rv;
+}
+
+/*
+ * Treat "\0", "AeonWave" (and "DirectSound3D", "DirectSound" and
+ * "MMSYSTEM") as a request for the Default sound output.
+ */
+static const ALCchar *
+_oalDeviceName(const ALCchar *name)
+{
+    if (name && (name[0] == '\0' || !strcasecmp(name, "AeonWave")
+#if _WIN32
+        || !strcasecmp(name, "DirectSound3D")
+        || !strcasecmp(name, "DirectSound")
+        || !strcasecmp(name, "MMSYSTEM")
+#endif
+        ))
+    {
+        name = NULL;
+    }
+
+    return name;
+}
+
+_alBufferData *
+_oalFindContextById(uint32_t id)
+{
+    _alBufferData *dptr = 0;
+    _alBuffers *contexts;
+
+    _AL_LOG(LOG_DEBUG, __FUNCTION__);
+
+    _alEpochEnter();
+    contexts = _oal_atomic_load(&_oalContexts);
+    if (contexts)
+    {
+        unsigned int pos = _alBufHandleToPos(contexts, _OAL_CONTEXT, id);
+        if (pos != UINT_MAX) {
+            dptr = _alBufGet(contexts, _OAL_CONTEXT, pos);
+        }
+    }
+    _alEpochLeave();
+
+    return dptr;
+}
+
 static _alBufferData *
 _oalFindContextByDeviceId(uint32_t id)
 {
-    _alBuffers *ctx;
     _alBufferData *dptr = 0;
     _oalDevice *dev;
 
     _AL_LOG(LOG_DEBUG, __FUNCTION__);
 
     dev = _oalFindDeviceById(id);
-    if (dev)
-    {
-        if (dev->current_context != UINT_MAX)
-        {
-            ctx = dev->contexts;
-            if (ctx) {
-                dptr =_alBufGet(ctx, _OAL_CONTEXT, dev->current_context);
-            }
-        }
+    if (dev) {
+        dptr = _oalFindContextById(dev->current_context);
     }
 
     return dptr;
@@ -863,21 +1405,39 @@ _oalCtxFreeSource(void *source)
     {
         if (src->parent)
         {
-            const _alBufferData *dptr_ctx = _oalGetCurrentContext();
-            if (dptr_ctx)
-            {
-                _oalContext *ctx = _alBufGetDataPtr(dptr_ctx);
-                const _oalDevice *dev = ctx->parent_device;
-                aaxMixerDeregisterEmitter(dev->lst.handle, src->handle);
-                src->parent = NULL;
-            }
+            /* the source is registered at the mixer of it's own device */
+            aaxMixerDeregisterEmitter(src->parent, src->handle);
+            src->parent = NULL;
         }
         aaxEmitterSetState(src->handle, AAX_STOPPED);
-        aaxEmitterDestroy(src->handle);
-        free(src);
+        _alEpochRetire(src, _oalDestroySource);
     }
 }
 
+/* Called by whoever releases the last reference to a closed device. */
+static void
+_oalFreeDevice(void *device)
+{
+    _oalDevice *d = (_oalDevice*)device;
+
+    _AL_LOG(LOG_DEBUG, __FUNCTION__);
+
+    d->current_context = 0;
+    if (_oalDeviceWait(d) == _OAL_DEVICE_READY)
+    {
+        aaxMixerSetState(d->lst.handle, AAX_STOPPED);
+
+        /* deleted sources still waiting to be freed use the mixer */
+        _alEpochWait();
+        aaxDriverClose(d->lst.handle);
+        aaxDriverDestroy(d->lst.handle);
+    }
+    _alBufErase(&d->buffers, _OAL_BUFFER, _oalFreeBuffer);
+    free(d->name);
+    free(d);
+}
+
+/* Called by whoever releases the last reference to a destroyed context. */
 static void
 _oalFreeContext(void *context)
 {
@@ -885,11 +1445,133 @@ _oalFreeContext(void *context)
 
     _AL_LOG(LOG_DEBUG, __FUNCTION__);
 
+    /* flushes the pending commands before the sources are gone */
+    _oalCommandQueueDestroy(ctx->queue);
     _alBufErase(&ctx->sources, _OAL_SOURCE, _oalCtxFreeSource);
+
+    /* destroy the emitters of all sources now, not after the device */
+    _alEpochWait();
+    _oalEmitterPoolDestroy(ctx);
+    _alSlabDestroy(ctx->slab);
     free(ctx->state);
+
+    /* frees the device if it was closed already */
+    _alBufReleaseData(ctx->dptr_dev, _OAL_DEVICE);
     free(ctx);
 }
 
+/*
+ * Report the usage of the source object pool of the current context or
+ * the buffer object pool of the device.
+ */
+static unsigned int
+_oalDeviceGetPoolStats(_oalDevice *dev, ALCenum attrib)
+{
+    _alSlabStats stats;
+
+    _AL_LOG(LOG_DEBUG, __FUNCTION__);
+
+    memset(&stats, 0, sizeof(_alSlabStats));
+    switch(attrib)
+    {
+    case ALC_SOURCE_POOL_SIZE_AAX:
+    case ALC_SOURCE_POOL_USED_AAX:
+    case ALC_SOURCE_POOL_PEAK_AAX:
+        {
+            _alBufferData *dptr;
+
+            dptr = _oalFindContextById(dev->current_context);
+            if (dptr)
+            {
+                _oalContext *ctx = _alBufGetDataPtr(dptr);
+                _alSlabGetStats(ctx->slab, &stats);
+                _alBufReleaseData(dptr, _OAL_CONTEXT);
+            }
+        }
+        break;
+    default:
+        if (dev->buffers) {
+            _alBufGetStats(dev->buffers, _OAL_BUFFER, &stats);
+        }
+        break;
+    }
+
+    switch(attrib)
+    {
+    case ALC_SOURCE_POOL_SIZE_AAX:
+    case ALC_BUFFER_POOL_SIZE_AAX:
+        return stats.total;
+    case ALC_SOURCE_POOL_USED_AAX:
+    case ALC_BUFFER_POOL_USED_AAX:
+        return stats.used;
+    default:
+        return stats.peak;
+    }
+}
+
+/*
+ * Fill in the attribute list of the current context of the device, using
+ * the values which are in effect rather than the requested ones. Returns
+ * the number of integers in the list including the terminating zero,
+ * which is never more than _OAL_MAX_ATTRIBUTES.
+ */
+static unsigned int
+_oalDeviceGetAttributes(_oalDevice *dev, ALCint *attr)
+{
+    aaxConfig config = dev->lst.handle;
+    unsigned int n = 0;
+    _alBufferData *dptr;
+    int freq, refresh;
+
+    _AL_LOG(LOG_DEBUG, __FUNCTION__);
+
+    freq = aaxMixerGetSetup(config, AAX_FREQUENCY);
+    refresh = aaxMixerGetSetup(config, AAX_REFRESH_RATE);
+
+    attr[n++] = ALC_FREQUENCY;
+    attr[n++] = freq;
+    attr[n++] = ALC_REFRESH;
+    attr[n++] = refresh;
+    attr[n++] = ALC_MONO_SOURCES;
+    attr[n++] = aaxMixerGetSetup(NULL, AAX_MONO_EMITTERS);
+    attr[n++] = ALC_STEREO_SOURCES;
+    attr[n++] = aaxMixerGetSetup(NULL, AAX_STEREO_EMITTERS);
+
+    dptr = _oalFindContextById(dev->current_context);
+    if (dptr)
+    {
+        _oalContext *ctx = _alBufGetDataPtr(dptr);
+        _alSlabStats stats;
+
+        _alSlabGetStats(ctx->slab, &stats);
+
+        attr[n++] = ALC_SYNC;
+        attr[n++] = ctx->sync;
+        /* every device is mixed by one AeonWave mixer thread */
+        attr[n++] = ALC_MIXER_THREADS_AAX;
+        attr[n++] = 1;
+        attr[n++] = ALC_PERIOD_SIZE_AAX;
+        attr[n++] = refresh ? freq/refresh : 0;
+        attr[n++] = ALC_UPDATE_MODE_AAX;
+        attr[n++] = ctx->queue ? ALC_UPDATE_QUEUED_AAX
+                               : ALC_UPDATE_IMMEDIATE_AAX;
+        attr[n++] = ALC_SOURCE_PREALLOC_AAX;
+        attr[n++] = _MIN(stats.total, ctx->max_emitters);
+        attr[n++] = ALC_BUFFER_PREALLOC_AAX;
+        attr[n++] = dev->buffers
+                    ? _alBufGetMaxNumNoLock(dev->buffers, _OAL_BUFFER) : 0;
+        attr[n++] = ALC_MAX_VOICES_AAX;
+        attr[n++] = _MIN(ctx->max_voices, INT_MAX);
+
+        _alBufReleaseData(dptr, _OAL_CONTEXT);
+    }
+    attr[n++] = 0;
+
+    assert(n <= _OAL_MAX_ATTRIBUTES);
+
+    return n;
+}
+
 static void
 _oalSourcesCreate(void *context)
 {
@@ -897,10 +1579,16 @@ _oalSourcesCreate(void *context)
 
     assert(ctx);
 
-    if (ctx->sources == 0)
+    if (ctx->slab == 0)
+    {
+        ctx->slab = _alSlabCreate(sizeof(_oalSource));
+        if (!ctx->slab) _oalContextSetError(ALC_OUT_OF_MEMORY);
+    }
+
+    if (ctx->sources == 0 && ctx->slab)
     {
         unsigned int r;
-        r = _alBufCreate(&ctx->sources, _OAL_SOURCE);
+        r = _alBufCreateMode(&ctx->sources, _OAL_SOURCE, BUFFER_HANDLES);
         if (r == UINT_MAX) _oalContextSetError(ALC_OUT_OF_MEMORY);
     }
 }
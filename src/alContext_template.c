@@ -38,10 +38,10 @@ ALCGETINTEGERV(N)(ALCdevice *device, ALCenum attrib, ALCsizei size, T *value)
     switch(attrib)
     {
     case ALC_MONO_SOURCES:
-        *value = (T)_MIN((unsigned)aaxMixerGetSetup(NULL, AAX_MONO_EMITTERS), 255);
+        *value = (T)aaxMixerGetSetup(NULL, AAX_MONO_EMITTERS);
         break;
     case ALC_STEREO_SOURCES:
-        *value = (T)_MIN((unsigned)aaxMixerGetSetup(NULL, AAX_STEREO_EMITTERS), 255);
+        *value = (T)aaxMixerGetSetup(NULL, AAX_STEREO_EMITTERS);
         break;
     case ALC_MAJOR_VERSION:
         *value = (T)_oalContextVersion[0];
@@ -55,9 +55,8 @@ ALCGETINTEGERV(N)(ALCdevice *device, ALCenum attrib, ALCsizei size, T *value)
     case ALC_EFX_MINOR_VERSION:
         *value = (T)_oalEFXVersion[1];
         break;
-    case ALC_ATTRIBUTES_SIZE:                   /* TODO */
-    case ALC_ALL_ATTRIBUTES:
-        *value = 0;
+    case ALC_DEVICE_STATE_AAX:
+        *value = (T)_oalDeviceGetState(_oalDeviceToId(device));
         break;
     default:
         done = 0;
@@ -66,9 +65,10 @@ ALCGETINTEGERV(N)(ALCdevice *device, ALCenum attrib, ALCsizei size, T *value)
     if (!done)
     {
         uint32_t id = _oalDeviceToId(device);
-        _oalDevice *dev = (_oalDevice *)_oalFindDeviceById(id);
-        if (dev)
+        _alBufferData *dptr = _oalGetDeviceById(id);
+        if (dptr)
         {
+            _oalDevice *dev = _alBufGetDataPtr(dptr);
             aaxConfig config = dev->lst.handle;
             switch(attrib)
             {
@@ -81,10 +81,42 @@ ALCGETINTEGERV(N)(ALCdevice *device, ALCenum attrib, ALCsizei size, T *value)
             case ALC_CAPTURE_SAMPLES:
                 *value = (T)aaxSensorGetOffset(config, AAX_SAMPLES);
                 break;
+            case ALC_SOURCE_POOL_SIZE_AAX:
+            case ALC_SOURCE_POOL_USED_AAX:
+            case ALC_SOURCE_POOL_PEAK_AAX:
+            case ALC_BUFFER_POOL_SIZE_AAX:
+            case ALC_BUFFER_POOL_USED_AAX:
+            case ALC_BUFFER_POOL_PEAK_AAX:
+                *value = (T)_oalDeviceGetPoolStats(dev, attrib);
+                break;
+            case ALC_ATTRIBUTES_SIZE:
+            {
+                ALCint attr[_OAL_MAX_ATTRIBUTES];
+                *value = (T)_oalDeviceGetAttributes(dev, attr);
+                break;
+            }
+            case ALC_ALL_ATTRIBUTES:
+            {
+                ALCint attr[_OAL_MAX_ATTRIBUTES];
+                ALCsizei i, num;
+
+                num = _oalDeviceGetAttributes(dev, attr);
+                if (size >= num)
+                {
+                    for (i=0; i<num; i++) {
+                        value[i] = (T)attr[i];
+                    }
+                }
+                else {
+                    _oalContextSetError(ALC_INVALID_VALUE);
+                }
+                break;
+            }
             default:
                 *value = 0;
                 _oalContextSetError(ALC_INVALID_ENUM);
             }
+            _alBufReleaseData(dptr, _OAL_DEVICE);
         }
         else {
             _oalContextSetError(ALC_INVALID_DEVICE);
@@ -33,6 +33,7 @@
 #include "api.h"
 
 _oalListener* _oalGetListeners(_oalContext *);
+static int _oalListenerDefer(_oalContext *, _oalListener *, unsigned int);
 
 /*
  * void alListeneri(ALenum attrib, ALint value)
@@ -91,3 +92,34 @@ _oalGetListeners(_oalContext *context)
     return lst;
 }
 
+void
+_oalUpdateListener(_oalListener *lst)
+{
+    _AL_LOG(LOG_DEBUG, __FUNCTION__);
+
+    if (lst->dirty & _OAL_DIRTY_MATRIX)
+    {
+        aaxMtx4d mtx;
+
+        aaxMatrix64SetOrientation(mtx, lst->pos, lst->at, lst->up);
+        aaxMatrix64Inverse(mtx);
+        aaxSensorSetMatrix64(lst->handle, mtx);
+    }
+    if (lst->dirty & _OAL_DIRTY_VELOCITY) {
+        aaxSensorSetVelocity(lst->handle, lst->vel);
+    }
+    lst->dirty = 0;
+}
+
+static int
+_oalListenerDefer(_oalContext *ctx, _oalListener *lst, unsigned int flag)
+{
+    int rv = 0;
+
+    if (ctx->suspend)
+    {
+        lst->dirty |= flag;
+        rv = -1;
+    }
+    return rv;
+}
@@ -70,7 +70,6 @@ ALLISTENERV(N)(ALenum attrib, const T *values)
         if (lst)
         {
             aaxConfig config = lst->handle;
-            aaxVec3f vec3f;
             aaxMtx4d mtx;
 
             switch(attrib)
@@ -79,9 +78,13 @@ ALLISTENERV(N)(ALenum attrib, const T *values)
                 lst->pos[0] = (double)values[0];
                 lst->pos[1] = (double)values[1];
                 lst->pos[2] = (double)values[2];
-                aaxMatrix64SetOrientation(mtx, lst->pos, lst->at, lst->up);
-                aaxMatrix64Inverse(mtx);
-                aaxSensorSetMatrix64(config, mtx);
+                if (!_oalListenerDefer(ctx, lst, _OAL_DIRTY_MATRIX))
+                {
+                    aaxMatrix64SetOrientation(mtx, lst->pos, lst->at, lst->up);
+                    aaxMatrix64Inverse(mtx);
+                    aaxSensorSetMatrix64(config, mtx);
+                    _oalVoicesUpdate(ctx, AL_FALSE);
+                }
                 break;
             case AL_ORIENTATION:
                 lst->at[0] = (float)values[0];
@@ -90,15 +93,20 @@ ALLISTENERV(N)(ALenum attrib, const T *values)
                 lst->up[0] = (float)values[3];
                 lst->up[1] = (float)values[4];
                 lst->up[2] = (float)values[5];
-                aaxMatrix64SetOrientation(mtx, lst->pos, lst->at, lst->up);
-                aaxMatrix64Inverse(mtx);
-                aaxSensorSetMatrix64(config, mtx);
+                if (!_oalListenerDefer(ctx, lst, _OAL_DIRTY_MATRIX))
+                {
+                    aaxMatrix64SetOrientation(mtx, lst->pos, lst->at, lst->up);
+                    aaxMatrix64Inverse(mtx);
+                    aaxSensorSetMatrix64(config, mtx);
+                }
                 break;
             case AL_VELOCITY:
-                vec3f[0] = (float)values[0];
-                vec3f[1] = (float)values[1];
-                vec3f[2] = (float)values[2];
-                aaxSensorSetVelocity(config, vec3f);
+                lst->vel[0] = (float)values[0];
+                lst->vel[1] = (float)values[1];
+                lst->vel[2] = (float)values[2];
+                if (!_oalListenerDefer(ctx, lst, _OAL_DIRTY_VELOCITY)) {
+                    aaxSensorSetVelocity(config, lst->vel);
+                }
                 break;
             /* AL_AAX_frequency_filter */
             case AL_FREQUENCY_FILTER_PARAMS_AAX:
@@ -267,7 +275,13 @@ ALGETLISTENERV(N)(ALenum attrib, T *values)
         case AL_VELOCITY:
         {
             aaxVec3f vec3f;
-            aaxSensorGetVelocity(config, vec3f);
+            if (lst->dirty & _OAL_DIRTY_VELOCITY) {
+                vec3f[0] = lst->vel[0];
+                vec3f[1] = lst->vel[1];
+                vec3f[2] = lst->vel[2];
+            } else {
+                aaxSensorGetVelocity(config, vec3f);
+            }
             values[0] = (T)vec3f[0];
             values[1] = (T)vec3f[1];
             values[2] = (T)vec3f[2];
@@ -25,6 +25,7 @@
 #if HAVE_ASSERT_H
 #include <assert.h>
 #endif
+#include <float.h>
 #include <math.h>
 
 #include <aax/aax.h>
@@ -33,12 +34,28 @@
 
 #include <base/types.h>
 #include <base/geometry.h>
+#include <base/atomic.h>
 
 #include "api.h"
 #include "aax_support.h"
 
+#define _OAL_SOURCES_ON_STACK	16
+
 static _alBuffers *_oalGetSources(void *);
 static const _alBufferData *_oalFindSourceById(ALuint, _alBuffers*, ALuint *);
+static _oalSource **_oalFindSources(_oalContext *, ALsizei, const ALuint *, _oalSource **);
+static int _oalSourceDefer(_oalSource *, unsigned int);
+static int _oalSourceQueue(_oalSource *, ALuint, ALenum, float, float, float);
+static unsigned int _oalSourceModifies(ALenum);
+static void _oalSourceSetParam(_oalSource *, ALuint, ALenum, float, float, float);
+static unsigned int _oalSourceApply(_oalSource *, ALenum, const float *);
+static void _oalSourcePush(_oalSource *, unsigned int);
+static aaxFilter _oalSourceFilter(_oalSource *, unsigned int);
+static aaxEffect _oalSourcePitchEffect(_oalSource *);
+static void _oalEmittersSetMatrix(const aaxEmitter *, const aaxVec3d *, const aaxVec3f *, aaxMtx4d *, unsigned int);
+static aaxEmitter _oalEmitterCreate(void);
+static aaxEmitter _oalEmitterGet(_oalContext *);
+static int _oalEmitterPut(_oalContext *, _oalSource *);
 
 AL_API ALboolean AL_APIENTRY
 alIsSource (ALuint id)
@@ -49,10 +66,13 @@ alIsSource (ALuint id)
     if (id)
     {
         ALuint pos;
+
+        _alEpochEnter();
         dptr = _oalFindSourceById(id, 0, &pos);
         if (dptr) {
             ret = AL_TRUE;
         }
+        _alEpochLeave();
     }
 
     return ret;
@@ -67,7 +87,7 @@ alGenSources(ALsizei num, ALuint *ids)
 
     if (!num) return;	/* nop */
 
-    if (ids == 0)
+    if ((ids == 0) || (num < 0))
     {
         _oalStateSetError(AL_INVALID_VALUE);
         return;
@@ -80,59 +100,79 @@ alGenSources(ALsizei num, ALuint *ids)
         _alBuffers *cs = _oalGetSources(ctx);
         if (cs)
         {
-            ALuint pos = UINT_MAX;
+            ALuint r = UINT_MAX;
             ALsizei i = 0;
-            ALint nsrcs;
+            unsigned int nsrcs;
+            void **srcs;
 
-            nsrcs = _MIN(aaxMixerGetSetup(NULL, AAX_MONO_EMITTERS), 255);
-            if (nsrcs < num) num = 0;
-            for (i=0; i<num; i++)
+            /*
+             * Sources are virtual: their number is only limited by the
+             * source table, the mixer is limited by the number of sources
+             * which are playing at the same time. See alVoice.c.
+             */
+            nsrcs = BUFFER_HANDLE_MAX - _alBufGetNumNoLock(cs, _OAL_SOURCE);
+            if (nsrcs < (unsigned int)num) num = 0;
+
+            srcs = (num > 0) ? calloc(num, sizeof(void*)) : NULL;
+            if (srcs)
             {
-                _oalSource *src = calloc(1, sizeof(_oalSource));
-                if (src != NULL)
+                for (i=0; i<num; i++)
                 {
-                    aaxFilter flt;
-
-                    src->handle = aaxEmitterCreate();
-                    if (!src->handle)
+                    _oalSource *src = _alSlabAlloc(ctx->slab);
+                    if (src != NULL)
                     {
-                        --i;
-                        pos = UINT_MAX;
+                        src->handle = _oalEmitterGet(ctx);
+                        if (!src->handle)
+                        {
+                            _alSlabFree(src);
+                            break;
+                        }
+                        src->context = ctx;
+                        src->gain = 1.0f;
+                        src->pitch = 1.0f;
+                        src->dirty = 0;
+                        src->modified = 0;
+                        src->mode = AAX_ABSOLUTE;
+                        src->priority = 1.0f;
+                        src->ref_distance = 1.0f;
+                        src->rolloff = 1.0f;
+                        src->max_distance = FLT_MAX;
+                        src->min_gain = 0.0f;
+                        src->max_gain = 1.0f;
+                        src->cone_inner = 360.0f;
+                        src->cone_outer = 360.0f;
+                        src->cone_outer_gain = 0.0f;
+                        src->looping = AL_FALSE;
+
+                        srcs[i] = src;
+                    }
+                    else {
                         break;
                     }
-                    src->mode = AAX_ABSOLUTE;
-                    aaxEmitterSetMode(src->handle, AAX_POSITION, src->mode);
-
-                    flt = aaxEmitterGetFilter(src->handle, AAX_VOLUME_FILTER);
-                    aaxFilterSetParam(flt, AAX_MIN_GAIN, AAX_LINEAR, 0.0f);
-                    aaxFilterSetParam(flt, AAX_MAX_GAIN, AAX_LINEAR, 1.0f);
-                    aaxEmitterSetFilter(src->handle, flt);
-
-                    flt = aaxEmitterGetFilter(src->handle, AAX_DISTANCE_FILTER);
-                    aaxFilterSetState(flt, AAX_AL_INVERSE_DISTANCE_CLAMPED);
-                    aaxEmitterSetFilter(src->handle, flt);
-
-                    pos = _alBufAddData(cs, _OAL_SOURCE, src);
-                    if (pos == UINT_MAX) break;
-
-                    ids[i] = _alBufPosToId(pos);
                 }
-                else {
-                    _oalStateSetError(AL_OUT_OF_MEMORY);
+
+                if (i == num)
+                {
+                    r = _alBufAddDataBatch(cs, _OAL_SOURCE,
+                                           (const void**)srcs, num, ids);
+                    if (r != UINT_MAX)
+                    {
+                        for (i=0; i<num; i++) {
+                            ids[i] = _alBufPosToHandle(cs, _OAL_SOURCE, ids[i]);
+                        }
+                    }
                 }
-            }
 
-            if (pos == UINT_MAX)
-            {
-                ALsizei pos, r;
-                for (r=0; r<i; r++)
+                if (r == UINT_MAX)	/* roll back */
                 {
-                    _oalSource *src;
-                    pos = _alBufIdToPos(ids[r]);
-                    src = _alBufRemove(cs, _OAL_SOURCE, pos, AL_FALSE);
-                    _oalFreeSource(ctx, src);
+                    while (i--) {
+                        _oalFreeSource(ctx, srcs[i]);
+                    }
                 }
+                free(srcs);
+            }
 
+            if (r == UINT_MAX) {
                 _oalStateSetError(AL_OUT_OF_MEMORY);
             }
         }
@@ -166,6 +206,7 @@ alDeleteSources(ALsizei num, const ALuint *ids)
 
         if ((unsigned int)num > _alBufGetMaxNumNoLock(cs, _OAL_SOURCE))
         {
+            _alBufReleaseData(dptr_ctx, _OAL_CONTEXT);
             _oalStateSetError(AL_INVALID_VALUE);
             return;
         }
@@ -188,11 +229,17 @@ alDeleteSources(ALsizei num, const ALuint *ids)
              */
             if (dptr_src)
             {
-                for (i=0; i<num; i++)
+                void **srcs = malloc(num * sizeof(void*));
+                if (srcs)
                 {
-                    _oalSource *src;
-                    src = _alBufRemove(cs, _OAL_SOURCE, pos[i], AL_FALSE);
-                    _oalFreeSource(ctx, src);
+                    _alBufRemoveBatch(cs, _OAL_SOURCE, pos, num, srcs);
+                    for (i=0; i<num; i++) {
+                        _oalFreeSource(ctx, srcs[i]);
+                    }
+                    free(srcs);
+                }
+                else {
+                    _oalStateSetError(AL_OUT_OF_MEMORY);
                 }
             }
             else {
@@ -229,6 +276,7 @@ alSourceQueueBuffers(ALuint id, ALsizei num, const ALuint *ids)
         _alBuffers *cs = _oalGetSources(ctx);
         unsigned int pos;
 
+        _alEpochEnter();
         dptr_src = _oalFindSourceById(id, cs, &pos);
         if (dptr_src)
         {
@@ -254,6 +302,7 @@ alSourceQueueBuffers(ALuint id, ALsizei num, const ALuint *ids)
         else {
             _oalStateSetError(AL_INVALID_NAME);
         }
+        _alEpochLeave();
         _alBufReleaseData(dptr_ctx, _OAL_CONTEXT);
     }
     else {
@@ -282,6 +331,7 @@ alSourceUnqueueBuffers(ALuint id, ALsizei num, ALuint *ids)
         _alBuffers *cs = _oalGetSources(ctx);
         unsigned int pos;
 
+        _alEpochEnter();
         dptr_src = _oalFindSourceById(id, cs, &pos);
         if (dptr_src)
         {
@@ -298,7 +348,7 @@ alSourceUnqueueBuffers(ALuint id, ALsizei num, ALuint *ids)
                 {
                     buf = aaxEmitterGetBufferByPos(src->handle, --i, AAX_FALSE);
                     pos = _alBufGetPos(db, _OAL_BUFFER, buf);
-                    ids[i] = _alBufPosToId(pos);
+                    ids[i] = _alBufPosToHandle(db, _OAL_BUFFER, pos);
                     if (ids[i] == 0) break;
                 }
                 while (i);
@@ -322,6 +372,7 @@ alSourceUnqueueBuffers(ALuint id, ALsizei num, ALuint *ids)
         else {
             _oalStateSetError(AL_INVALID_NAME);
         }
+        _alEpochLeave();
         _alBufReleaseData(dptr_ctx, _OAL_CONTEXT);
     }
     else {
@@ -335,6 +386,12 @@ alSourcePlay(ALuint id)
     alSourcePlayv(1, &id);
 }
 
+/*
+ * All sources get their voice first and are started together afterwards,
+ * so the group starts on the same mixer period. With the asynchronous
+ * command queue the sources start after the commands which were queued
+ * before, a source doesn't start at its previous position.
+ */
 AL_API void AL_APIENTRY
 alSourcePlayv(ALsizei num, const ALuint *ids)
 {
@@ -344,7 +401,7 @@ alSourcePlayv(ALsizei num, const ALuint *ids)
 
     if (num == 0) return;
 
-    if (ids == NULL)
+    if (ids == NULL || num < 0)
     {
         _oalStateSetError(AL_INVALID_VALUE);
         return;
@@ -354,33 +411,54 @@ alSourcePlayv(ALsizei num, const ALuint *ids)
     if (dptr_ctx)
     {
         _oalContext *ctx = _alBufGetDataPtr(dptr_ctx);
-        _alBuffers *cs = _oalGetSources(ctx);
-        unsigned int pos;
-        ALsizei i = num;
+        _oalSource *buf[_OAL_SOURCES_ON_STACK];
+        _oalSource **list;
+
+        if (ctx->queue) {
+            _oalCommandQueueFlush(ctx->queue);
+        }
 
-        do
+        _alEpochEnter();
+        list = _oalFindSources(ctx, num, ids, buf);
+        if (list)
         {
-            const _alBufferData *dptr;
+            char update = AL_FALSE;
+            ALsizei i;
 
-            dptr = _oalFindSourceById(ids[--i], cs, &pos);
-            if (dptr)
+            for (i=0; i<num; i++)
             {
-                _oalSource *src = _alBufGetDataPtr(dptr);
-                if (!src->parent)
-                {
-                    _oalDevice *dev = (_oalDevice *)ctx->parent_device;
+                _oalSource *src = list[i];
 
-                    aaxMixerRegisterEmitter(dev->lst.handle, src->handle);
-                    src->parent = dev->lst.handle;
+                /* playing a virtual source restarts it from the beginning */
+                if (src->virtual == AL_PLAYING) {
+                    src->virtual = 0;
                 }
 
-                if (aaxEmitterGetState(src->handle) == AAX_PLAYING) {
+                if (!src->parent && !_oalVoiceAcquire(ctx, src))
+                {
+                    /* without a voice the source continues virtually */
+                    _oalVoicePlay(src);
+                    update = AL_TRUE;
+                }
+                else if (aaxEmitterGetState(src->handle) == AAX_PLAYING) {
                     aaxEmitterSetState(src->handle, AAX_INITIALIZED);
                 }
-                aaxEmitterSetState(src->handle, AAX_PLAYING);
             }
+
+            for (i=0; i<num; i++)
+            {
+                if (list[i]->parent) {
+                    aaxEmitterSetState(list[i]->handle, AAX_PLAYING);
+                }
+            }
+
+            /* a new source might be more audible than one with a voice */
+            if (update) {
+                _oalVoicesUpdate(ctx, AL_FALSE);
+            }
+            if (list != buf) free(list);
         }
-        while (i);
+        _alEpochLeave();
 
         _alBufReleaseData(dptr_ctx, _OAL_CONTEXT);
     }
@@ -398,24 +476,52 @@ alSourcePause(ALuint id)
 AL_API void AL_APIENTRY
 alSourcePausev(ALsizei num, const ALuint *ids)
 {
-    ALsizei i;
+    const _alBufferData *dptr_ctx;
 
     _AL_LOG(LOG_INFO, __FUNCTION__);
 
-    assert(ids);
+    if (num == 0) return;
 
-    for (i=0; i<num; i++)
+    if (ids == NULL || num < 0)
     {
-        const _alBufferData *dptr;
-        unsigned int pos;
-        _oalSource *src;
+        _oalStateSetError(AL_INVALID_VALUE);
+        return;
+    }
+
+    dptr_ctx = _oalGetCurrentContext();
+    if (dptr_ctx)
+    {
+        _oalContext *ctx = _alBufGetDataPtr(dptr_ctx);
+        _oalSource *buf[_OAL_SOURCES_ON_STACK];
+        _oalSource **list;
 
-        dptr = _oalFindSourceById(ids[i], 0, &pos);
-        if (dptr)
+        _alEpochEnter();
+        list = _oalFindSources(ctx, num, ids, buf);
+        if (list)
         {
-            src = _alBufGetDataPtr(dptr);
-            aaxEmitterSetState(src->handle, AAX_SUSPENDED);
+            ALsizei i;
+
+            /* virtual sources first, they don't need the mixer */
+            for (i=0; i<num; i++)
+            {
+                if (list[i]->virtual) {
+                    _oalVoicePause(list[i]);
+                }
+            }
+            for (i=0; i<num; i++)
+            {
+                if (!list[i]->virtual) {
+                    _oalVoicePause(list[i]);
+                }
+            }
+            if (list != buf) free(list);
         }
+        _alEpochLeave();
+
+        _alBufReleaseData(dptr_ctx, _OAL_CONTEXT);
+    }
+    else {
+        _oalStateSetError(AL_INVALID_OPERATION);
     }
 }
 
@@ -434,7 +540,7 @@ alSourceStopv(ALsizei num, const ALuint *ids)
 
     if (num == 0) return;
 
-    if (ids == NULL)
+    if (ids == NULL || num < 0)
     {
         _oalStateSetError(AL_INVALID_VALUE);
         return;
@@ -444,30 +550,33 @@ alSourceStopv(ALsizei num, const ALuint *ids)
     if (dptr_ctx)
     {
         _oalContext *ctx = _alBufGetDataPtr(dptr_ctx);
-        _alBuffers *cs = _oalGetSources(ctx);
-        unsigned int pos;
-        ALsizei i = num;
+        _oalSource *buf[_OAL_SOURCES_ON_STACK];
+        _oalSource **list;
 
-        do
+        _alEpochEnter();
+        list = _oalFindSources(ctx, num, ids, buf);
+        if (list)
         {
-            const _alBufferData *dptr;
+            ALsizei i;
 
-            dptr = _oalFindSourceById(ids[--i], cs, &pos);
-            if (dptr)
+            for (i=0; i<num; i++)
             {
-                const _oalDevice *dev = ctx->parent_device;
-                _oalSource *src = _alBufGetDataPtr(dptr);
+                list[i]->virtual = 0;
+                aaxEmitterSetState(list[i]->handle, AAX_STOPPED);
+            }
 
-                aaxEmitterSetState(src->handle, AAX_STOPPED);
-                aaxMixerDeregisterEmitter(dev->lst.handle, src->handle);
-                src->parent = NULL;
+            /* the voices are released after all sources are stopped */
+            for (i=0; i<num; i++) {
+                _oalVoiceRelease(ctx, list[i]);
             }
+            if (list != buf) free(list);
         }
-        while (i);
+        _alEpochLeave();
 
         _alBufReleaseData(dptr_ctx, _OAL_CONTEXT);
     }
     else {
+        _oalStateSetError(AL_INVALID_OPERATION);
     }
 }
 
@@ -480,24 +589,44 @@ alSourceRewind(ALuint id)
 AL_API void AL_APIENTRY
 alSourceRewindv(ALsizei num, const ALuint *ids)
 {
-    ALsizei i;
+    const _alBufferData *dptr_ctx;
 
     _AL_LOG(LOG_INFO, __FUNCTION__);
 
-    assert(ids);
+    if (num == 0) return;
 
-    for (i=0; i<num; i++)
+    if (ids == NULL || num < 0)
     {
-        const _alBufferData *dptr;
-        _oalSource *src;
-        unsigned int pos;
+        _oalStateSetError(AL_INVALID_VALUE);
+        return;
+    }
+
+    dptr_ctx = _oalGetCurrentContext();
+    if (dptr_ctx)
+    {
+        _oalContext *ctx = _alBufGetDataPtr(dptr_ctx);
+        _oalSource *buf[_OAL_SOURCES_ON_STACK];
+        _oalSource **list;
 
-        dptr = _oalFindSourceById(ids[i], 0, &pos);
-        if (dptr)
+        _alEpochEnter();
+        list = _oalFindSources(ctx, num, ids, buf);
+        if (list)
         {
-            src = _alBufGetDataPtr(dptr);
-            aaxEmitterSetState(src->handle, AAX_INITIALIZED);
+            ALsizei i;
+
+            for (i=0; i<num; i++)
+            {
+                list[i]->virtual = 0;
+                aaxEmitterSetState(list[i]->handle, AAX_INITIALIZED);
+            }
+            if (list != buf) free(list);
         }
+        _alEpochLeave();
+
+        _alBufReleaseData(dptr_ctx, _OAL_CONTEXT);
+    }
+    else {
+        _oalStateSetError(AL_INVALID_OPERATION);
     }
 }
 
@@ -623,6 +752,130 @@ alGetSourcei64vSOFT(ALuint source, ALenum param, ALint64SOFT *values) {
 }
 /* AL_SOFT_source_latency */
 
+/*
+ * AL_AAX_source_batch: set the same attribute of num sources in one call.
+ * The context and the source table are resolved only once. values holds
+ * one element per source: three floats for AL_POSITION, AL_DIRECTION,
+ * AL_VELOCITY and AL_FREQUENCY_FILTER_PARAMS_AAX and a single float for
+ * all other attributes.
+ */
+ALEXT_API void ALEXT_APIENTRY
+alSourcefvBatchAAX(ALsizei num, const ALuint *ids, ALenum attrib, const ALfloat *values)
+{
+    const _alBufferData *dptr_ctx;
+
+    _AL_LOG(LOG_INFO, __FUNCTION__);
+
+    if (num == 0) return;
+
+    if (!ids || !values || (num < 0))
+    {
+        _oalStateSetError(AL_INVALID_VALUE);
+        return;
+    }
+
+    dptr_ctx = _oalGetCurrentContext();
+    if (dptr_ctx)
+    {
+        _oalContext *ctx = _alBufGetDataPtr(dptr_ctx);
+        _alBuffers *cs = _oalGetSources(ctx);
+        aaxEmitter *emitters = NULL;
+        aaxVec3d *mpos = NULL;
+        aaxVec3f *mat = NULL;
+        aaxMtx4d *mtx = NULL;
+        unsigned int stride = 1;
+        unsigned int pos, n = 0;
+        ALsizei i;
+
+        switch(attrib)
+        {
+        case AL_POSITION:
+        case AL_DIRECTION:
+            /*
+             * Unless the updates are held back anyhow the matrices are
+             * gathered and built in one pass after all sources are set.
+             */
+            if (!ctx->suspend && !ctx->queue)
+            {
+                mtx = malloc(num*(sizeof(aaxMtx4d) + sizeof(aaxVec3d) +
+                                  sizeof(aaxEmitter) + sizeof(aaxVec3f)));
+                if (mtx)
+                {
+                    mpos = (aaxVec3d*)(mtx + num);
+                    emitters = (aaxEmitter*)(mpos + num);
+                    mat = (aaxVec3f*)(emitters + num);
+                }
+            }
+            /* fall through */
+        case AL_VELOCITY:
+        case AL_FREQUENCY_FILTER_PARAMS_AAX:
+            stride = 3;
+            break;
+        default:
+            break;
+        }
+
+        _alEpochEnter();
+        for (i=0; i<num; i++)
+        {
+            const _alBufferData *dptr;
+
+            dptr = _oalFindSourceById(ids[i], cs, &pos);
+            if (dptr && mtx)
+            {
+                _oalSource *src = _alBufGetDataPtr(dptr);
+
+                src->modified |= _oalSourceModifies(attrib);
+                if (attrib == AL_POSITION)
+                {
+                    src->pos[0] = (double)values[0];
+                    src->pos[1] = (double)values[1];
+                    src->pos[2] = (double)values[2];
+                }
+                else
+                {
+                    src->at[0] = values[0];
+                    src->at[1] = values[1];
+                    src->at[2] = values[2];
+                    if (!values[0] && !values[1] && !values[2]) {
+                        _oalSourceSetParam(src, ids[i], attrib, 0.0f, 0.0f, 0.0f);
+                    }
+                }
+
+                emitters[n] = src->handle;
+                mpos[n][0] = src->pos[0];
+                mpos[n][1] = src->pos[1];
+                mpos[n][2] = src->pos[2];
+                mat[n][0] = src->at[0];
+                mat[n][1] = src->at[1];
+                mat[n][2] = src->at[2];
+                n++;
+            }
+            else if (dptr) {
+                _oalSourceSetfv(_alBufGetDataPtr(dptr), ids[i], attrib, values);
+            } else {
+                _oalStateSetError(AL_INVALID_NAME);
+            }
+            values += stride;
+        }
+
+        if (n)
+        {
+            _oalEmittersSetMatrix(emitters, mpos, mat, mtx, n);
+            if (attrib == AL_POSITION) {
+                _oalVoicesUpdate(ctx, AL_FALSE);
+            }
+        }
+        _alEpochLeave();
+        free(mtx);
+
+        _alBufReleaseData(dptr_ctx, _OAL_CONTEXT);
+    }
+    else {
+        _oalStateSetError(AL_INVALID_OPERATION);
+    }
+}
+
 static _alBuffers *
 _oalGetSources(void *context)
 {
@@ -650,6 +903,49 @@ _oalGetSources(void *context)
     return cs;
 }
 
+/*
+ * Look up the sources of a state change call for all ids at once. Returns
+ * NULL with AL_INVALID_NAME set if any of the ids is unknown, in which case
+ * none of the sources may change state. Up to _OAL_SOURCES_ON_STACK sources
+ * are stored in buf, the caller frees the list if it isn't buf.
+ * Must be called from within an epoch section.
+ */
+static _oalSource **
+_oalFindSources(_oalContext *ctx, ALsizei num, const ALuint *ids,
+                _oalSource **buf)
+{
+    _alBuffers *cs = _oalGetSources(ctx);
+    _oalSource **rv = buf;
+    ALsizei i;
+
+    if (num > _OAL_SOURCES_ON_STACK)
+    {
+        rv = malloc(num*sizeof(_oalSource*));
+        if (!rv)
+        {
+            _oalStateSetError(AL_OUT_OF_MEMORY);
+            return rv;
+        }
+    }
+
+    for (i=0; i<num; i++)
+    {
+        const _alBufferData *dptr;
+        unsigned int pos;
+
+        dptr = _oalFindSourceById(ids[i], cs, &pos);
+        if (!dptr)
+        {
+            _oalStateSetError(AL_INVALID_NAME);
+            if (rv != buf) free(rv);
+            return NULL;
+        }
+        rv[i] = _alBufGetDataPtr(dptr);
+    }
+
+    return rv;
+}
+
 static const _alBufferData *
 _oalFindSourceById(ALuint id, _alBuffers *scs, ALuint *rpos)
 {
@@ -661,8 +957,7 @@ _oalFindSourceById(ALuint id, _alBuffers *scs, ALuint *rpos)
 
     *rpos = UINT_MAX;
 
-    pos = _alBufIdToPos(id);
-    if (pos != UINT_MAX)
+    if (id)
     {
         _alBufferData *dptr_ctx = NULL;
         _oalContext *ctx = NULL;
@@ -675,8 +970,8 @@ _oalFindSourceById(ALuint id, _alBuffers *scs, ALuint *rpos)
 
         if (cs)
         {
-            ALuint num = _alBufGetMaxNumNoLock(cs, _OAL_SOURCE);
-            if (pos < num)
+            pos = _alBufHandleToPos(cs, _OAL_SOURCE, id);
+            if (pos != UINT_MAX)
             {
                 dptr_src = _alBufGetNoLock(cs, _OAL_SOURCE, pos);
                 if (dptr_src) {
@@ -703,15 +998,633 @@ _oalFreeSource(void *context, void *source)
 
     if (src)
     {
-        if (src->parent)
+        if (src->dirty && !ctx->queue)
         {
-            const _oalDevice *dev = ctx->parent_device;
-            aaxMixerDeregisterEmitter(dev->lst.handle, src->handle);
-            src->parent = NULL; 
+            ctx->dirty--;
+            src->dirty = 0;
         }
+
+        src->virtual = 0;
+        _oalVoiceRelease(ctx, src);
         aaxEmitterSetState(src->handle, AAX_STOPPED);
+
+        /*
+         * With the command queue enabled the worker thread might still
+         * update the emitter, so it can't be recycled right away.
+         */
+        if (!ctx->queue && _oalEmitterPut(ctx, src)) {
+            src->handle = NULL;
+        }
+
+        /* lock-free readers might still be using the source */
+        _alEpochRetire(src, _oalDestroySource);
+    }
+}
+
+void
+_oalDestroySource(void *source)
+{
+    _oalSource *src = (_oalSource*)source;
+    unsigned int i;
+
+    for (i=0; i<_OAL_FILTER_MAX; i++)
+    {
+        if (src->filter[i]) {
+            aaxFilterDestroy(src->filter[i]);
+        }
+    }
+    if (src->pitch_effect) {
+        aaxEffectDestroy(src->pitch_effect);
+    }
+    if (src->handle) {
         aaxEmitterDestroy(src->handle);
-        free(src);
     }
+    _alSlabFree(src);
+}
+
+/*
+ * Send the updates which were held back while the context was suspended
+ * to AeonWave, in one pass over the sources of the context. With the
+ * command queue enabled this is called by the worker thread only and the
+ * vectors come from its own copy. The positions
+ * and directions of the sources with a changed matrix are gathered first
+ * and the matrices are built and sent for all of them at the end.
+ */
+void
+_oalUpdateSources(void *context)
+{
+    _oalContext *ctx = (_oalContext*)context;
+    _alBuffers *cs = ctx->sources;
+    unsigned int i, num, max, n = 0;
+    aaxEmitter *emitters = NULL;
+    aaxVec3d *pos = NULL;
+    aaxVec3f *at = NULL;
+    aaxMtx4d *mtx;
+
+    _AL_LOG(LOG_DEBUG, __FUNCTION__);
+
+    if (!ctx->dirty || !cs) return;
+
+    max = ctx->dirty;
+    mtx = malloc(max*(sizeof(aaxMtx4d) + sizeof(aaxVec3d) +
+                      sizeof(aaxEmitter) + sizeof(aaxVec3f)));
+    if (mtx)
+    {
+        pos = (aaxVec3d*)(mtx + max);
+        emitters = (aaxEmitter*)(pos + max);
+        at = (aaxVec3f*)(emitters + max);
+    }
+
+    _alEpochEnter();
+    num = _alBufGetMaxNumNoLock(cs, _OAL_SOURCE);
+    for (i=0; i<num && ctx->dirty; i++)
+    {
+        const _alBufferData *dptr = _alBufGetNoLock(cs, _OAL_SOURCE, i);
+        _oalSource *src = dptr ? _alBufGetDataPtr(dptr) : NULL;
+
+        if (src && src->dirty)
+        {
+            aaxEmitter emitter = src->handle;
+            aaxVec3d *spos = ctx->queue ? &src->queued_pos : &src->pos;
+            aaxVec3f *sat = ctx->queue ? &src->queued_at : &src->at;
+            aaxVec3f *svel = ctx->queue ? &src->queued_vel : &src->vel;
+
+            if ((src->dirty & _OAL_DIRTY_MATRIX) && mtx && n < max)
+            {
+                emitters[n] = emitter;
+                pos[n][0] = (*spos)[0];
+                pos[n][1] = (*spos)[1];
+                pos[n][2] = (*spos)[2];
+                at[n][0] = (*sat)[0];
+                at[n][1] = (*sat)[1];
+                at[n][2] = (*sat)[2];
+                n++;
+            }
+            else if (src->dirty & _OAL_DIRTY_MATRIX) {
+                _oalEmittersSetMatrix(&emitter, spos, sat, NULL, 1);
+            }
+            if (src->dirty & _OAL_DIRTY_VELOCITY) {
+                aaxEmitterSetVelocity(emitter, *svel);
+            }
+
+            /* every filter is sent once, no matter how often it changed */
+            _oalSourcePush(src, src->dirty);
+            src->dirty = 0;
+            ctx->dirty--;
+        }
+    }
+
+    /* sources which got deleted while they were dirty aren't counted */
+    ctx->dirty = 0;
+
+    if (n) {
+        _oalEmittersSetMatrix(emitters, pos, at, mtx, n);
+    }
+    _alEpochLeave();
+
+    free(mtx);
+}
+
+/*
+ * Fold a command from the asynchronous command queue into the state the
+ * worker thread sends to the emitter. The shadow state was already updated
+ * by the setter. Called by the worker thread of the queue only.
+ */
+void
+_oalSourceCommand(void *context, ALuint id, ALenum attrib, const float *v)
+{
+    _oalContext *ctx = (_oalContext*)context;
+    const _alBufferData *dptr;
+    ALuint pos;
+
+    dptr = _oalFindSourceById(id, ctx->sources, &pos);
+    if (dptr)
+    {
+        _oalSource *src = _alBufGetDataPtr(dptr);
+        unsigned int flag = 0;
+
+        switch(attrib)
+        {
+        case AL_POSITION:
+            src->queued_pos[0] = (double)v[0];
+            src->queued_pos[1] = (double)v[1];
+            src->queued_pos[2] = (double)v[2];
+            flag = _OAL_DIRTY_MATRIX;
+            break;
+        case AL_DIRECTION:
+            src->queued_at[0] = v[0];
+            src->queued_at[1] = v[1];
+            src->queued_at[2] = v[2];
+            flag = _OAL_DIRTY_MATRIX | _oalSourceApply(src, attrib, v);
+            break;
+        case AL_VELOCITY:
+            src->queued_vel[0] = v[0];
+            src->queued_vel[1] = v[1];
+            src->queued_vel[2] = v[2];
+            flag = _OAL_DIRTY_VELOCITY;
+            break;
+        default:
+            flag = _oalSourceApply(src, attrib, v);
+            break;
+        }
+
+        if (flag)
+        {
+            if (!src->dirty) ctx->dirty++;
+            src->dirty |= flag;
+        }
+    }
+}
+
+/*
+ * Set a source attribute which is kept in a filter or effect of the
+ * emitter. With the command queue enabled the worker thread is the only
+ * one which touches the cached filters, the effect and the dirty flags of
+ * the source so the update is queued and applied by _oalSourceCommand.
+ */
+static void
+_oalSourceSetParam(_oalSource *src, ALuint id, ALenum attrib,
+                   float v1, float v2, float v3)
+{
+    if (!_oalSourceQueue(src, id, attrib, v1, v2, v3))
+    {
+        float v[3];
+        unsigned int flag;
+
+        v[0] = v1;
+        v[1] = v2;
+        v[2] = v3;
+        flag = _oalSourceApply(src, attrib, v);
+        if (flag && !_oalSourceDefer(src, flag)) {
+            _oalSourcePush(src, flag);
+        }
+    }
+}
+
+/*
+ * Change the cached filter or effect which holds attrib and return the
+ * dirty flag which sends it to the emitter. For AL_DISTANCE_MODEL v[0] is
+ * the AeonWave distance model, for AL_DIRECTION only the zero vector
+ * changes a filter.
+ */
+static unsigned int
+_oalSourceApply(_oalSource *src, ALenum attrib, const float *v)
+{
+    unsigned int slot = _OAL_FILTER_MAX;
+    aaxFilter flt = NULL;
+    aaxEffect eff;
+
+    switch(attrib)
+    {
+    case AL_GAIN:
+    case AL_MIN_GAIN:
+    case AL_MAX_GAIN:
+        slot = _OAL_FILTER_VOLUME;
+        break;
+    case AL_DISTANCE_MODEL:
+    case AL_REFERENCE_DISTANCE:
+    case AL_ROLLOFF_FACTOR:
+    case AL_MAX_DISTANCE:
+        slot = _OAL_FILTER_DISTANCE;
+        break;
+    case AL_DIRECTION:
+        if (v[0] || v[1] || v[2]) return 0;
+        /* fall through */
+    case AL_CONE_INNER_ANGLE:
+    case AL_CONE_OUTER_ANGLE:
+    case AL_CONE_OUTER_GAIN:
+        slot = _OAL_FILTER_DIRECTIONAL;
+        break;
+    case AL_FREQUENCY_FILTER_PARAMS_AAX:
+    case AL_FREQUENCY_FILTER_ENABLE_AAX:
+    case AL_FREQUENCY_FILTER_GAINLF_AAX:
+    case AL_FREQUENCY_FILTER_GAINHF_AAX:
+    case AL_FREQUENCY_FILTER_CUTOFF_FREQ_AAX:
+        slot = _OAL_FILTER_FREQUENCY;
+        break;
+    case AL_PITCH:
+        eff = _oalSourcePitchEffect(src);
+        aaxEffectSetParam(eff, AAX_PITCH, AAX_LINEAR, v[0]);
+        return _OAL_DIRTY_PITCH;
+    default:
+        return 0;
+    }
+
+    flt = _oalSourceFilter(src, slot);
+    switch(attrib)
+    {
+    case AL_GAIN:
+        aaxFilterSetParam(flt, AAX_GAIN, AAX_LINEAR, v[0]);
+        break;
+    case AL_MIN_GAIN:
+        aaxFilterSetParam(flt, AAX_MIN_GAIN, AAX_LINEAR, v[0]);
+        break;
+    case AL_MAX_GAIN:
+        aaxFilterSetParam(flt, AAX_MAX_GAIN, AAX_LINEAR, v[0]);
+        break;
+    case AL_DISTANCE_MODEL:
+        aaxFilterSetState(flt, (int)v[0]);
+        break;
+    case AL_REFERENCE_DISTANCE:
+        aaxFilterSetParam(flt, AAX_REF_DISTANCE, AAX_LINEAR, v[0]);
+        break;
+    case AL_ROLLOFF_FACTOR:
+        aaxFilterSetParam(flt, AAX_ROLLOFF_FACTOR, AAX_LINEAR, v[0]);
+        break;
+    case AL_MAX_DISTANCE:
+        aaxFilterSetParam(flt, AAX_MAX_DISTANCE, AAX_LINEAR, v[0]);
+        break;
+    case AL_DIRECTION:
+        aaxFilterSetParam(flt, AAX_INNER_ANGLE, AAX_DEGREES, 360.0f);
+        break;
+    case AL_CONE_INNER_ANGLE:
+        aaxFilterSetParam(flt, AAX_INNER_ANGLE, AAX_DEGREES, v[0]);
+        break;
+    case AL_CONE_OUTER_ANGLE:
+        aaxFilterSetParam(flt, AAX_OUTER_ANGLE, AAX_DEGREES, v[0]);
+        break;
+    case AL_CONE_OUTER_GAIN:
+        aaxFilterSetParam(flt, AAX_OUTER_GAIN, AAX_LINEAR, v[0]);
+        break;
+    case AL_FREQUENCY_FILTER_PARAMS_AAX:
+        aaxFilterSetSlot(flt, 0, AAX_LINEAR, v[0], v[1], v[2], 0.0f);
+        break;
+    case AL_FREQUENCY_FILTER_ENABLE_AAX:
+        aaxFilterSetState(flt, (int)v[0]);
+        break;
+    case AL_FREQUENCY_FILTER_GAINLF_AAX:
+        aaxFilterSetParam(flt, AAX_LF_GAIN, AAX_LINEAR, v[0]);
+        break;
+    case AL_FREQUENCY_FILTER_GAINHF_AAX:
+        aaxFilterSetParam(flt, AAX_HF_GAIN, AAX_LINEAR, v[0]);
+        break;
+    case AL_FREQUENCY_FILTER_CUTOFF_FREQ_AAX:
+        aaxFilterSetParam(flt, AAX_CUTOFF_FREQUENCY, AAX_LINEAR, v[0]);
+        break;
+    default:
+        break;
+    }
+
+    return _OAL_DIRTY_FILTER(slot);
+}
+
+/* Send the cached filters and the effect which are flagged to AeonWave. */
+static void
+_oalSourcePush(_oalSource *src, unsigned int flags)
+{
+    unsigned int slot;
+
+    for (slot=0; slot<_OAL_FILTER_MAX; slot++)
+    {
+        if (flags & _OAL_DIRTY_FILTER(slot)) {
+            aaxEmitterSetFilter(src->handle, src->filter[slot]);
+        }
+    }
+    if (flags & _OAL_DIRTY_PITCH) {
+        aaxEmitterSetEffect(src->handle, src->pitch_effect);
+    }
+}
+
+/*
+ * Returns the filter of the source for slot, which is fetched from the
+ * emitter the first time it is needed and kept until the source gets
+ * destroyed. Changes to it take effect after _oalSourcePush.
+ */
+static aaxFilter
+_oalSourceFilter(_oalSource *src, unsigned int slot)
+{
+    static const enum aaxFilterType type[_OAL_FILTER_MAX] = {
+        AAX_VOLUME_FILTER, AAX_DISTANCE_FILTER,
+        AAX_DIRECTIONAL_FILTER, AAX_FREQUENCY_FILTER
+    };
+
+    if (!src->filter[slot]) {
+        src->filter[slot] = aaxEmitterGetFilter(src->handle, type[slot]);
+    }
+    return src->filter[slot];
+}
+
+static aaxEffect
+_oalSourcePitchEffect(_oalSource *src)
+{
+    if (!src->pitch_effect) {
+        src->pitch_effect = aaxEmitterGetEffect(src->handle, AAX_PITCH_EFFECT);
+    }
+    return src->pitch_effect;
+}
+
+/*
+ * Build the matrices of num emitters from contiguous arrays of positions
+ * and directions in one pass and send them to AeonWave in a second pass.
+ * Without a matrix array each matrix is sent as soon as it is built.
+ */
+static void
+_oalEmittersSetMatrix(const aaxEmitter *emitters, const aaxVec3d *pos,
+                      const aaxVec3f *at, aaxMtx4d *mtx, unsigned int num)
+{
+    unsigned int i;
+
+    if (mtx)
+    {
+        for (i=0; i<num; i++) {
+            aaxMatrix64SetDirection(mtx[i], pos[i], at[i]);
+        }
+        for (i=0; i<num; i++) {
+            aaxEmitterSetMatrix64(emitters[i], mtx[i]);
+        }
+    }
+    else
+    {
+        aaxMtx4d m;
+        for (i=0; i<num; i++)
+        {
+            aaxMatrix64SetDirection(m, pos[i], at[i]);
+            aaxEmitterSetMatrix64(emitters[i], m);
+        }
+    }
+}
+
+/*
+ * Returns non-zero if the update should be held back because the context
+ * of the source is suspended. Never called with the command queue
+ * enabled, the worker thread owns the dirty flags then.
+ */
+static int
+_oalSourceDefer(_oalSource *src, unsigned int flag)
+{
+    _oalContext *ctx = (_oalContext*)src->context;
+    int rv = 0;
+
+    if (ctx->suspend)
+    {
+        if (!src->dirty) ctx->dirty++;
+        src->dirty |= flag;
+        rv = -1;
+    }
+    return rv;
+}
+
+/*
+ * Returns non-zero if the update was handed to the asynchronous command
+ * queue of the context of the source.
+ */
+static int
+_oalSourceQueue(_oalSource *src, ALuint id, ALenum attrib,
+                float v1, float v2, float v3)
+{
+    _oalContext *ctx = (_oalContext*)src->context;
+    int rv = 0;
+
+    if (ctx->queue)
+    {
+        _oalCommandQueuePush(ctx->queue, id, attrib, v1, v2, v3);
+        rv = -1;
+    }
+    return rv;
+}
+
+/*
+ * Returns the _OAL_RESET flag of the source attribute which gets changed.
+ * Attributes which are reset anyway when the source is recycled, like the
+ * buffers, the state and the offset, return zero.
+ */
+static unsigned int
+_oalSourceModifies(ALenum attrib)
+{
+    switch(attrib)
+    {
+    case AL_POSITION:
+    case AL_DIRECTION:
+        return _OAL_RESET_MATRIX;
+    case AL_VELOCITY:
+        return _OAL_RESET_VELOCITY;
+    case AL_GAIN:
+    case AL_MIN_GAIN:
+    case AL_MAX_GAIN:
+        return _OAL_RESET_VOLUME;
+    case AL_PITCH:
+        return _OAL_RESET_PITCH;
+    case AL_SOURCE_RELATIVE:
+    case AL_LOOPING:
+    case AL_BUFFER:		/* multi-channel buffers disable positioning */
+        return _OAL_RESET_MODE;
+    case AL_SOURCE_STATE:
+    case AL_SOURCE_TYPE:
+    case AL_SEC_OFFSET:
+    case AL_SAMPLE_OFFSET:
+    case AL_BYTE_OFFSET:
+        return 0;
+    default:
+        return _OAL_RESET_NONE;
+    }
+}
+
+/* Create an emitter which is set up with the OpenAL source defaults */
+static aaxEmitter
+_oalEmitterCreate(void)
+{
+    aaxEmitter emitter = aaxEmitterCreate();
+    if (emitter)
+    {
+        aaxFilter flt;
+
+        aaxEmitterSetMode(emitter, AAX_POSITION, AAX_ABSOLUTE);
+
+        flt = aaxEmitterGetFilter(emitter, AAX_VOLUME_FILTER);
+        aaxFilterSetParam(flt, AAX_MIN_GAIN, AAX_LINEAR, 0.0f);
+        aaxFilterSetParam(flt, AAX_MAX_GAIN, AAX_LINEAR, 1.0f);
+        aaxEmitterSetFilter(emitter, flt);
+        aaxFilterDestroy(flt);
+
+        flt = aaxEmitterGetFilter(emitter, AAX_DISTANCE_FILTER);
+        aaxFilterSetState(flt, AAX_AL_INVERSE_DISTANCE_CLAMPED);
+        aaxEmitterSetFilter(emitter, flt);
+        aaxFilterDestroy(flt);
+    }
+    return emitter;
+}
+
+/*
+ * Fill the emitter pool of the context with 'num' emitters.
+ * Returns the number of emitters in the pool.
+ */
+unsigned int
+_oalEmitterPoolCreate(void *context, unsigned int num)
+{
+    _oalContext *ctx = (_oalContext*)context;
+
+    _AL_LOG(LOG_DEBUG, __FUNCTION__);
+
+    assert(!ctx->emitters);
+
+    ctx->emitters = malloc(num*sizeof(aaxEmitter));
+    if (ctx->emitters)
+    {
+        ctx->max_emitters = num;
+        while (ctx->num_emitters < num)
+        {
+            aaxEmitter emitter = _oalEmitterCreate();
+            if (!emitter) break;
+            ctx->emitters[ctx->num_emitters++] = emitter;
+        }
+    }
+    return ctx->num_emitters;
+}
+
+void
+_oalEmitterPoolDestroy(void *context)
+{
+    _oalContext *ctx = (_oalContext*)context;
+
+    _AL_LOG(LOG_DEBUG, __FUNCTION__);
+
+    while (ctx->num_emitters) {
+        aaxEmitterDestroy(ctx->emitters[--ctx->num_emitters]);
+    }
+    free(ctx->emitters);
+    ctx->emitters = NULL;
+    ctx->max_emitters = 0;
+}
+
+static void
+_oalEmitterPoolLock(_oalContext *ctx)
+{
+    unsigned int expected = 0;
+    while (!_oal_atomic_cas(&ctx->emitters_lock, &expected, 1)) {
+        expected = 0;
+    }
+}
+
+static void
+_oalEmitterPoolUnlock(_oalContext *ctx)
+{
+    _oal_atomic_store(&ctx->emitters_lock, 0);
+}
+
+/* Get an emitter from the pool, or create a new one if it's empty */
+static aaxEmitter
+_oalEmitterGet(_oalContext *ctx)
+{
+    aaxEmitter rv = NULL;
+
+    if (ctx->emitters)
+    {
+        _oalEmitterPoolLock(ctx);
+        if (ctx->num_emitters) {
+            rv = ctx->emitters[--ctx->num_emitters];
+        }
+        _oalEmitterPoolUnlock(ctx);
+    }
+
+    if (!rv) {
+        rv = _oalEmitterCreate();
+    }
+    return rv;
 }
 
+/*
+ * Reset the emitter of a deleted source to the source defaults and return
+ * it to the pool. Returns zero if the pool is full or if the source was
+ * changed in a way which can't be undone cheaply.
+ */
+static int
+_oalEmitterPut(_oalContext *ctx, _oalSource *src)
+{
+    aaxEmitter emitter = src->handle;
+    unsigned int modified = src->modified;
+    unsigned int num;
+    int rv = 0;
+
+    if (!ctx->emitters || (modified & _OAL_RESET_NONE) ||
+        _oal_atomic_load(&ctx->num_emitters) >= ctx->max_emitters)
+    {
+        return rv;
+    }
+
+    aaxEmitterSetState(emitter, AAX_INITIALIZED);
+    num = aaxEmitterGetNoBuffers(emitter, AAX_MAXIMUM);
+    while (num--) {
+        aaxEmitterRemoveBuffer(emitter);
+    }
+
+    if (modified & _OAL_RESET_MATRIX)
+    {
+        aaxMtx4d mtx;
+        aaxMatrix64SetIdentityMatrix(mtx);
+        aaxEmitterSetMatrix64(emitter, mtx);
+    }
+    if (modified & _OAL_RESET_VELOCITY)
+    {
+        aaxVec3f vel = { 0.0f, 0.0f, 0.0f };
+        aaxEmitterSetVelocity(emitter, vel);
+    }
+    if (modified & _OAL_RESET_VOLUME)
+    {
+        aaxFilter flt = _oalSourceFilter(src, _OAL_FILTER_VOLUME);
+        aaxFilterSetParam(flt, AAX_GAIN, AAX_LINEAR, 1.0f);
+        aaxFilterSetParam(flt, AAX_MIN_GAIN, AAX_LINEAR, 0.0f);
+        aaxFilterSetParam(flt, AAX_MAX_GAIN, AAX_LINEAR, 1.0f);
+        aaxEmitterSetFilter(emitter, flt);
+    }
+    if (modified & _OAL_RESET_PITCH)
+    {
+        aaxEffect eff = _oalSourcePitchEffect(src);
+        aaxEffectSetParam(eff, AAX_PITCH, AAX_LINEAR, 1.0f);
+        aaxEmitterSetEffect(emitter, eff);
+    }
+    if (modified & _OAL_RESET_MODE)
+    {
+        aaxEmitterSetMode(emitter, AAX_POSITION, AAX_ABSOLUTE);
+        aaxEmitterSetMode(emitter, AAX_LOOPING, AAX_FALSE);
+    }
+
+    _oalEmitterPoolLock(ctx);
+    if (ctx->num_emitters < ctx->max_emitters)
+    {
+        ctx->emitters[ctx->num_emitters++] = emitter;
+        rv = -1;
+    }
+    _oalEmitterPoolUnlock(ctx);
+
+    return rv;
+}
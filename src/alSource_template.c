@@ -22,6 +22,7 @@
 #if defined(N) && defined(T)
 
 # define __ALSOURCEV(NAME) 	alSource##NAME##v
+# define __OALSOURCESETV(NAME)	_oalSourceSet##NAME##v
 # define __ALSOURCE3(NAME)	alSource3##NAME
 # define __ALSOURCE(NAME)	alSource##NAME
 # define __ALGETSOURCEV(NAME)	alGetSource##NAME##v
@@ -29,6 +30,7 @@
 # define __ALGETSOURCE(NAME)	alGetSource##NAME
 
 # define ALSOURCEV(NAME)	__ALSOURCEV(NAME)
+# define OALSOURCESETV(NAME)	__OALSOURCESETV(NAME)
 # define ALSOURCE3(NAME)	__ALSOURCE3(NAME)
 # define ALSOURCE(NAME)		__ALSOURCE(NAME)
 # define ALGETSOURCEV(NAME)	__ALGETSOURCEV(NAME)
@@ -50,6 +52,74 @@ ALSOURCE3(N)(ALuint id, ALenum attrib, T v1, T v2, T v3)
     ALSOURCEV(N)(id, attrib, (T*)&Tv);
 }
 
+/*
+ * Set a vector attribute of a source which was already looked up, this
+ * is shared by ALSOURCEV and the batch functions of AL_AAX_source_batch.
+ */
+static void
+OALSOURCESETV(N)(_oalSource *src, ALuint id, ALenum attrib, const T *values)
+{
+    aaxEmitter emitter = src->handle;
+    aaxMtx4d mtx;
+
+    src->modified |= _oalSourceModifies(attrib);
+    switch(attrib)
+    {
+    case AL_POSITION:
+        src->pos[0] = (double)values[0];
+        src->pos[1] = (double)values[1];
+        src->pos[2] = (double)values[2];
+        _oalVoicesUpdate(src->context, AL_FALSE);
+        if (_oalSourceQueue(src, id, attrib, (float)values[0],
+                            (float)values[1], (float)values[2])) {
+            break;
+        }
+        if (!_oalSourceDefer(src, _OAL_DIRTY_MATRIX))
+        {
+            aaxMatrix64SetDirection(mtx, src->pos, src->at);
+            aaxEmitterSetMatrix64(emitter, mtx);
+        }
+        break;
+    case AL_DIRECTION:
+        src->at[0] = (float)values[0];
+        src->at[1] = (float)values[1];
+        src->at[2] = (float)values[2];
+        if (_oalSourceQueue(src, id, attrib, (float)values[0],
+                            (float)values[1], (float)values[2])) {
+            break;
+        }
+        if (!values[0] && !values[1] && !values[2]) {
+            _oalSourceSetParam(src, id, attrib, 0.0f, 0.0f, 0.0f);
+        }
+        if (!_oalSourceDefer(src, _OAL_DIRTY_MATRIX))
+        {
+            aaxMatrix64SetDirection(mtx, src->pos, src->at);
+            aaxEmitterSetMatrix64(emitter, mtx);
+        }
+        break;
+    case AL_VELOCITY:
+        src->vel[0] = (float)values[0];
+        src->vel[1] = (float)values[1];
+        src->vel[2] = (float)values[2];
+        if (_oalSourceQueue(src, id, attrib, (float)values[0],
+                            (float)values[1], (float)values[2])) {
+            break;
+        }
+        if (!_oalSourceDefer(src, _OAL_DIRTY_VELOCITY)) {
+            aaxEmitterSetVelocity(emitter, src->vel);
+        }
+        break;
+    /* AL_AAX_frequency_filter */
+    case AL_FREQUENCY_FILTER_PARAMS_AAX:
+        _oalSourceSetParam(src, id, attrib, (float)values[0],
+                           (float)values[1], (float)values[2]);
+        break;
+    default:
+        ALSOURCE(N)(id, attrib, *values);
+        break;
+    }
+}
+
 AL_API void AL_APIENTRY
 ALSOURCEV(N)(ALuint id, ALenum attrib, const T *values)
 {
@@ -64,63 +134,15 @@ ALSOURCEV(N)(ALuint id, ALenum attrib, const T *values)
         return;
     }
 
+    _alEpochEnter();
     dptr = _oalFindSourceById(id, 0, &pos);
-    if (dptr)
-    {
-        _oalSource *src = _alBufGetDataPtr(dptr);
-        aaxEmitter emitter = src->handle;
-        aaxVec3f vec3f;
-        aaxMtx4d mtx;
-
-        switch(attrib)
-        {
-        case AL_POSITION:
-            src->pos[0] = (double)values[0];
-            src->pos[1] = (double)values[1];
-            src->pos[2] = (double)values[2];
-            aaxMatrix64SetDirection(mtx, src->pos, src->at);
-            aaxEmitterSetMatrix64(emitter, mtx);
-            break;
-        case AL_DIRECTION:
-            src->at[0] = (float)values[0];
-            src->at[1] = (float)values[1];
-            src->at[2] = (float)values[2];
-            if (!values[0] && !values[1] && !values[2]) {
-                aaxFilter flt;
-                flt = aaxEmitterGetFilter(emitter, AAX_DIRECTIONAL_FILTER);
-                aaxFilterSetParam(flt, AAX_INNER_ANGLE, AAX_DEGREES, 360.0f);
-                aaxEmitterSetFilter(emitter, flt);
-                aaxFilterDestroy(flt);
-            }
-            aaxMatrix64SetDirection(mtx, src->pos, src->at);
-            aaxEmitterSetMatrix64(emitter, mtx);
-            break;
-        case AL_VELOCITY:
-            vec3f[0] = (float)values[0];
-            vec3f[1] = (float)values[1];
-            vec3f[2] = (float)values[2];
-            aaxEmitterSetVelocity(emitter, vec3f);
-            break;
-        /* AL_AAX_frequency_filter */
-        case AL_FREQUENCY_FILTER_PARAMS_AAX:
-        {
-            aaxFilter flt;
-            flt = aaxEmitterGetFilter(emitter, AAX_FREQUENCY_FILTER );
-            aaxFilterSetSlot(flt, 0, AAX_LINEAR, values[0],values[1],values[2],0.0f);
-            aaxEmitterSetFilter(emitter, flt);
-            aaxFilterDestroy(flt);
-            break;
-        }
-        default:
-            ALSOURCE(N)(id, attrib, *values);
-            break;
-        }
+    if (dptr) {
+        OALSOURCESETV(N)(_alBufGetDataPtr(dptr), id, attrib, values);
     }
-    else
-    {
+    else {
         _oalStateSetError(AL_INVALID_NAME);
-        return;
     }
+    _alEpochLeave();
 }
 
 AL_API void AL_APIENTRY
@@ -137,6 +159,7 @@ ALSOURCE(N)(ALuint id, ALenum attrib, T value)
         return;
     }
 
+    _alEpochEnter();
     dptr = _oalFindSourceById(id, 0, &pos);
     if (dptr)
     {
@@ -144,8 +167,8 @@ ALSOURCE(N)(ALuint id, ALenum attrib, T value)
         aaxEmitter emitter = src->handle;
         unsigned int ival = (unsigned int)value;
         float fval = (float)value;
-        aaxEffect eff;
-        aaxFilter flt;
+
+        src->modified |= _oalSourceModifies(attrib);
         switch(attrib)
         {
         case AL_SOURCE_STATE:
@@ -199,14 +222,9 @@ ALSOURCE(N)(ALuint id, ALenum attrib, T value)
             case AL_EXPONENT_DISTANCE_DELAY_CLAMPED_AAX:
                 if (alIsEnabled(AL_SOURCE_DISTANCE_MODEL))
                 {
-                    aaxFilter flt;
                     char ddelay = alIsEnabled(AL_DISTANCE_DELAY_MODEL_AAX);
                     ival = _oalDistanceModeltoAAXDistanceModel(ival, ddelay);
-
-                    flt = aaxEmitterGetFilter(emitter, AAX_DISTANCE_FILTER);
-                    aaxFilterSetState(flt, ival);
-                    aaxEmitterSetFilter(emitter, flt);
-                    aaxFilterDestroy(flt);
+                    _oalSourceSetParam(src, id, attrib, (float)ival, 0.0f, 0.0f);
                 }
                 break;
             default:
@@ -215,6 +233,7 @@ ALSOURCE(N)(ALuint id, ALenum attrib, T value)
             }
             break;
         case AL_LOOPING:
+            src->looping = ival ? AL_TRUE : AL_FALSE;
             aaxEmitterSetMode(emitter, AAX_LOOPING, ival);
             break;
         case AL_BUFFER:
@@ -264,67 +283,57 @@ ALSOURCE(N)(ALuint id, ALenum attrib, T value)
             }
             break;
         case AL_GAIN:
-            flt = aaxEmitterGetFilter(src->handle, AAX_VOLUME_FILTER);
-            aaxFilterSetParam(flt, AAX_GAIN, AAX_LINEAR, fval);
-            aaxEmitterSetFilter(src->handle, flt);
-            aaxFilterDestroy(flt);
+            src->gain = fval;
+            _oalSourceSetParam(src, id, attrib, fval, 0.0f, 0.0f);
+            _oalVoicesUpdate(src->context, AL_FALSE);
             break;
         case AL_MIN_GAIN:
-            flt = aaxEmitterGetFilter(src->handle, AAX_VOLUME_FILTER);
-            aaxFilterSetParam(flt, AAX_MIN_GAIN, AAX_LINEAR, fval);
-            aaxEmitterSetFilter(src->handle, flt);
-            aaxFilterDestroy(flt);
+            src->min_gain = fval;
+            _oalSourceSetParam(src, id, attrib, fval, 0.0f, 0.0f);
             break;
         case AL_MAX_GAIN:
-            flt = aaxEmitterGetFilter(src->handle, AAX_VOLUME_FILTER);
-            aaxFilterSetParam(flt, AAX_MAX_GAIN, AAX_LINEAR, fval);
-            aaxEmitterSetFilter(src->handle, flt);
-            aaxFilterDestroy(flt);
+            src->max_gain = fval;
+            _oalSourceSetParam(src, id, attrib, fval, 0.0f, 0.0f);
             break;
         case AL_REFERENCE_DISTANCE:
-            flt = aaxEmitterGetFilter(src->handle, AAX_DISTANCE_FILTER);
-            aaxFilterSetParam(flt, AAX_REF_DISTANCE, AAX_LINEAR, fval);
-            aaxEmitterSetFilter(src->handle, flt);
-            aaxFilterDestroy(flt);
+            src->ref_distance = fval;
+            _oalSourceSetParam(src, id, attrib, fval, 0.0f, 0.0f);
             break;
         case AL_ROLLOFF_FACTOR:
-            flt = aaxEmitterGetFilter(src->handle, AAX_DISTANCE_FILTER);
-            aaxFilterSetParam(flt, AAX_ROLLOFF_FACTOR, AAX_LINEAR, fval);
-            aaxEmitterSetFilter(src->handle, flt);
-            aaxFilterDestroy(flt);
+            src->rolloff = fval;
+            _oalSourceSetParam(src, id, attrib, fval, 0.0f, 0.0f);
             break;
         case AL_MAX_DISTANCE:
-            flt = aaxEmitterGetFilter(src->handle, AAX_DISTANCE_FILTER);
-            aaxFilterSetParam(flt, AAX_MAX_DISTANCE, AAX_LINEAR, fval);
-            aaxEmitterSetFilter(src->handle, flt);
-            aaxFilterDestroy(flt);
+            src->max_distance = fval;
+            _oalSourceSetParam(src, id, attrib, fval, 0.0f, 0.0f);
             break;
         case AL_PITCH:
-            eff = aaxEmitterGetEffect(src->handle, AAX_PITCH_EFFECT);
-            aaxEffectSetParam(eff, AAX_PITCH, AAX_LINEAR, fval);
-            aaxEmitterSetEffect(src->handle, eff);
-            aaxEffectDestroy(eff);
+            src->pitch = fval;
+            _oalSourceSetParam(src, id, attrib, fval, 0.0f, 0.0f);
             break;
         case AL_CONE_INNER_ANGLE:
-            flt = aaxEmitterGetFilter(src->handle, AAX_DIRECTIONAL_FILTER);
-            aaxFilterSetParam(flt, AAX_INNER_ANGLE, AAX_DEGREES, fval);
-            aaxEmitterSetFilter(src->handle, flt);
-            aaxFilterDestroy(flt);
+            src->cone_inner = fval;
+            _oalSourceSetParam(src, id, attrib, fval, 0.0f, 0.0f);
             break;
         case AL_CONE_OUTER_ANGLE:
-            flt = aaxEmitterGetFilter(src->handle, AAX_DIRECTIONAL_FILTER);
-            aaxFilterSetParam(flt, AAX_OUTER_ANGLE, AAX_DEGREES, fval);
-            aaxEmitterSetFilter(src->handle, flt);
-            aaxFilterDestroy(flt);
+            src->cone_outer = fval;
+            _oalSourceSetParam(src, id, attrib, fval, 0.0f, 0.0f);
             break;
         case AL_CONE_OUTER_GAIN:
-            flt = aaxEmitterGetFilter(src->handle, AAX_DIRECTIONAL_FILTER);
-            aaxFilterSetParam(flt, AAX_OUTER_GAIN, AAX_LINEAR, fval);
-            aaxEmitterSetFilter(src->handle, flt);
-            aaxFilterDestroy(flt);
+            src->cone_outer_gain = fval;
+            _oalSourceSetParam(src, id, attrib, fval, 0.0f, 0.0f);
             break;
         case AL_SEC_OFFSET:
-            aaxEmitterSetOffsetSec(emitter, fval);
+            if (src->virtual) {
+                _oalVoiceSetOffset(src, fval);
+            } else {
+                aaxEmitterSetOffsetSec(emitter, fval);
+            }
+            break;
+        /* AL_AAX_source_priority */
+        case AL_SOURCE_PRIORITY_AAX:
+            src->priority = fval;
+            _oalVoicesUpdate(src->context, AL_FALSE);
             break;
         /* AL_AAX_distance_delay_model */
         case AL_DISTANCE_DELAY_MODEL_AAX:
@@ -334,28 +343,17 @@ ALSOURCE(N)(ALuint id, ALenum attrib, T value)
             break;
         /* AL_AAX_frequency_filter */
         case AL_FREQUENCY_FILTER_ENABLE_AAX:
-            flt = aaxEmitterGetFilter(emitter, AAX_FREQUENCY_FILTER);
-            aaxFilterSetState(flt, value ? AAX_TRUE : AAX_FALSE);
-            aaxEmitterSetFilter(emitter, flt);
-            aaxFilterDestroy(flt);
+            fval = (float)(value ? AAX_TRUE : AAX_FALSE);
+            _oalSourceSetParam(src, id, attrib, fval, 0.0f, 0.0f);
             break;
         case AL_FREQUENCY_FILTER_GAINLF_AAX:
-            flt = aaxEmitterGetFilter(emitter, AAX_FREQUENCY_FILTER );
-            aaxFilterSetParam(flt, AAX_LF_GAIN, AAX_LINEAR, fval);
-            aaxEmitterSetFilter(emitter, flt);
-            aaxFilterDestroy(flt);
+            _oalSourceSetParam(src, id, attrib, fval, 0.0f, 0.0f);
             break;
         case AL_FREQUENCY_FILTER_GAINHF_AAX:
-            flt = aaxEmitterGetFilter(emitter, AAX_FREQUENCY_FILTER );
-            aaxFilterSetParam(flt, AAX_HF_GAIN, AAX_LINEAR, fval);
-            aaxEmitterSetFilter(emitter, flt);
-            aaxFilterDestroy(flt);
+            _oalSourceSetParam(src, id, attrib, fval, 0.0f, 0.0f);
             break;
         case AL_FREQUENCY_FILTER_CUTOFF_FREQ_AAX:
-            flt = aaxEmitterGetFilter(emitter, AAX_FREQUENCY_FILTER );
-            aaxFilterSetParam(flt, AAX_CUTOFF_FREQUENCY, AAX_LINEAR, fval);
-            aaxEmitterSetFilter(emitter, flt);
-            aaxFilterDestroy(flt);
+            _oalSourceSetParam(src, id, attrib, fval, 0.0f, 0.0f);
             break;
         default:
             _oalStateSetError(AL_INVALID_ENUM);
@@ -364,8 +362,8 @@ ALSOURCE(N)(ALuint id, ALenum attrib, T value)
     else
     {
         _oalStateSetError(AL_INVALID_NAME);
-        return;
     }
+    _alEpochLeave();
 }
 
 
@@ -394,36 +392,28 @@ ALGETSOURCEV(N)(ALuint id, ALenum attrib, T *values)
         return;
     }
 
+    _alEpochEnter();
     dptr = _oalFindSourceById(id, 0, &pos);
     if (dptr)
     {
-        _oalSource *src = _alBufGetDataPtr(dptr);
-        aaxEmitter emitter = src->handle;
-        aaxVec3d vec3d;
-        aaxVec3f vec3f;
-        aaxMtx4d mtx;
+        const _oalSource *src = _alBufGetDataPtr(dptr);
 
         switch(attrib)
         {
         case AL_POSITION:
-            aaxEmitterGetMatrix64(emitter, mtx);
-            aaxMatrix64GetOrientation(mtx, vec3d, NULL, NULL);
-            values[0] = (T)vec3d[0];
-            values[1] = (T)vec3d[1];
-            values[2] = (T)vec3d[2];
+            values[0] = (T)src->pos[0];
+            values[1] = (T)src->pos[1];
+            values[2] = (T)src->pos[2];
             break;
         case AL_DIRECTION:
-            aaxEmitterGetMatrix64(emitter, mtx);
-            aaxMatrix64GetOrientation(mtx, NULL, vec3f, NULL);
-            values[0] = (T)vec3f[0];
-            values[1] = (T)vec3f[1];
-            values[2] = (T)vec3f[2];
+            values[0] = (T)src->at[0];
+            values[1] = (T)src->at[1];
+            values[2] = (T)src->at[2];
             break;
         case AL_VELOCITY:
-            aaxEmitterGetVelocity(emitter, vec3f);
-            values[0] = (T)vec3f[0];
-            values[1] = (T)vec3f[1];
-            values[2] = (T)vec3f[2];
+            values[0] = (T)src->vel[0];
+            values[1] = (T)src->vel[1];
+            values[2] = (T)src->vel[2];
             break;
         default:
             ALGETSOURCE(N)(id, attrib, values);
@@ -433,8 +423,8 @@ ALGETSOURCEV(N)(ALuint id, ALenum attrib, T *values)
     else
     {
       _oalStateSetError(AL_INVALID_NAME);
-      return;
     }
+    _alEpochLeave();
 }
 
 AL_API void AL_APIENTRY
@@ -451,20 +441,20 @@ ALGETSOURCE(N)(ALuint id, ALenum attrib, T *value)
         return;
     }
 
+    _alEpochEnter();
     dptr = _oalFindSourceById(id, 0, &pos);
     if (dptr)
     {
         _oalSource *src = _alBufGetDataPtr(dptr);
         aaxEmitter emitter = src->handle;
-        aaxEffect eff;
-        aaxFilter flt;
 
         switch(attrib)
         {
         case AL_SOURCE_STATE:
         {
             enum aaxState state = aaxEmitterGetState(emitter);
-            if (state == AAX_INITIALIZED) *value = (T)AL_INITIAL;
+            if (_oalVoiceState(src)) *value = (T)src->virtual;
+            else if (state == AAX_INITIALIZED) *value = (T)AL_INITIAL;
             else if (state == AAX_PLAYING) *value = (T)AL_PLAYING;
             else if (state == AAX_STOPPED) *value = (T)AL_STOPPED;
             else if (state == AAX_SUSPENDED) *value = (T)AL_PAUSED;
@@ -479,7 +469,7 @@ ALGETSOURCE(N)(ALuint id, ALenum attrib, T *value)
             break;
         }
         case AL_LOOPING:
-            *value = (T)aaxEmitterGetMode(emitter, AAX_LOOPING);
+            *value = (T)src->looping;
             break;
         case AL_SOURCE_TYPE:
         {
@@ -490,7 +480,7 @@ ALGETSOURCE(N)(ALuint id, ALenum attrib, T *value)
             break;
         }
         case AL_SOURCE_RELATIVE:
-            if (aaxEmitterGetMode(emitter, AAX_POSITION) == AAX_RELATIVE) {
+            if (src->mode == AAX_RELATIVE) {
                 *value = (T)AL_TRUE;
             } else {
                 *value = (T)AL_FALSE;
@@ -509,7 +499,7 @@ ALGETSOURCE(N)(ALuint id, ALenum attrib, T *value)
             {
                 _alBuffers *db = _oalGetBuffers(NULL);
                 unsigned int pos = _alBufGetPos(db, _OAL_BUFFER, buf);
-                *value = (T)_alBufPosToId(pos);
+                *value = (T)_alBufPosToHandle(db, _OAL_BUFFER, pos);
             } else {
                 *value = 0;
             }
@@ -531,57 +521,44 @@ ALGETSOURCE(N)(ALuint id, ALenum attrib, T *value)
             break;
         }
         case AL_SEC_OFFSET:
-            *value = (T)aaxEmitterGetOffsetSec(emitter);
+            if (src->virtual) {
+                *value = (T)_oalVoiceOffset(src);
+            } else {
+                *value = (T)aaxEmitterGetOffsetSec(emitter);
+            }
+            break;
+        case AL_SOURCE_PRIORITY_AAX:
+            *value = (T)src->priority;
             break;
         case AL_GAIN:
-            flt = aaxEmitterGetFilter(emitter, AAX_VOLUME_FILTER);
-            *value = (T)aaxFilterGetParam(flt, AAX_GAIN, AAX_LINEAR);
-            aaxFilterDestroy(flt);
+            *value = (T)src->gain;
             break;
         case AL_MIN_GAIN:
-            flt = aaxEmitterGetFilter(emitter, AAX_VOLUME_FILTER);
-            *value = (T)aaxFilterGetParam(flt, AAX_MIN_GAIN, AAX_LINEAR);
-            aaxFilterDestroy(flt);
+            *value = (T)src->min_gain;
             break;
         case AL_MAX_GAIN:
-            flt = aaxEmitterGetFilter(emitter, AAX_VOLUME_FILTER);
-            *value = (T)aaxFilterGetParam(flt, AAX_MAX_GAIN, AAX_LINEAR);
-            aaxFilterDestroy(flt);
+            *value = (T)src->max_gain;
             break;
         case AL_PITCH:
-            eff = aaxEmitterGetEffect(emitter, AAX_PITCH_EFFECT);
-            *value = (T)aaxEffectGetParam(eff, AAX_PITCH, AAX_LINEAR);
-            aaxEffectDestroy(eff);
+            *value = (T)src->pitch;
             break;
         case AL_REFERENCE_DISTANCE:
-            flt = aaxEmitterGetFilter(emitter, AAX_DISTANCE_FILTER);
-            *value = (T)aaxFilterGetParam(flt, AAX_REF_DISTANCE, AAX_LINEAR);
-            aaxFilterDestroy(flt);
+            *value = (T)src->ref_distance;
             break;
         case AL_ROLLOFF_FACTOR:
-            flt = aaxEmitterGetFilter(emitter, AAX_DISTANCE_FILTER);
-            *value = (T)aaxFilterGetParam(flt, AAX_ROLLOFF_FACTOR, AAX_LINEAR);
-            aaxFilterDestroy(flt);
+            *value = (T)src->rolloff;
             break;
         case AL_MAX_DISTANCE:
-            flt = aaxEmitterGetFilter(emitter, AAX_DISTANCE_FILTER);
-            *value = (T)aaxFilterGetParam(flt, AAX_MAX_DISTANCE, AAX_LINEAR);
-            aaxFilterDestroy(flt);
+            *value = (T)src->max_distance;
             break;
         case AL_CONE_INNER_ANGLE:
-            flt = aaxEmitterGetFilter(emitter, AAX_DIRECTIONAL_FILTER);
-            *value = (T)aaxFilterGetParam(flt, AAX_INNER_ANGLE, AAX_DEGREES);
-            aaxFilterDestroy(flt);
+            *value = (T)src->cone_inner;
             break;
         case AL_CONE_OUTER_ANGLE:
-            flt = aaxEmitterGetFilter(emitter, AAX_DIRECTIONAL_FILTER);
-            *value = (T)aaxFilterGetParam(flt, AAX_OUTER_ANGLE, AAX_DEGREES);
-            aaxFilterDestroy(flt);
+            *value = (T)src->cone_outer;
             break;
         case AL_CONE_OUTER_GAIN:
-            flt = aaxEmitterGetFilter(emitter, AAX_DIRECTIONAL_FILTER);
-            *value = (T)aaxFilterGetParam(flt, AAX_OUTER_GAIN, AAX_LINEAR);
-            aaxFilterDestroy(flt);
+            *value = (T)src->cone_outer_gain;
             break;
         /* AL_EXT_source_latency */
         case AL_SAMPLE_OFFSET_LATENCY:
@@ -624,8 +601,8 @@ ALGETSOURCE(N)(ALuint id, ALenum attrib, T *value)
     else
     {
       _oalStateSetError(AL_INVALID_NAME);
-      return;
     }
+    _alEpochLeave();
 }
 
 # undef BITSHIFT
@@ -633,12 +610,14 @@ ALGETSOURCE(N)(ALuint id, ALenum attrib, T *value)
 # undef __ALGETSOURCE3
 # undef __ALGETSOURCE
 # undef __ALSOURCEV
+# undef __OALSOURCESETV
 # undef __ALSOURCE3
 # undef __ALSOURCE
 # undef ALGETSOURCEV
 # undef ALGETSOURCE3
 # undef ALGETSOURCE
 # undef ALSOURCEV
+# undef OALSOURCESETV
 # undef ALSOURCE3
 # undef ALSOURCE
 # undef N
@@ -0,0 +1,399 @@
+/*
+ * Copyright (C) 2007-2016 by Erik Hofman.
+ * Copyright (C) 2007-2016 by Adalin B.V.
+ *
+ * This file is part of AeonWave-OpenAL.
+ *
+ *  AeonWave-OpenAL is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  AeonWave-OpenAL is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with AeonWave-OpenAL.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Voice management.
+ *
+ * A voice is an emitter which is registered at the mixer of the device.
+ * The number of voices of a context is limited by ALC_MAX_VOICES_AAX
+ * while the number of sources isn't. When a source starts playing and no
+ * voice is left it plays virtually: only the time at which it started is
+ * recorded and the source reports AL_PLAYING to the application.
+ *
+ * Every now and then the playing sources are ranked by their audibility,
+ * which is the gain times the priority times the distance attenuation
+ * relative to the listener. The most audible sources get a voice, the
+ * voices of the others are taken away and they continue virtually. A
+ * source which gets a voice back resumes at the position it would have
+ * been at when it would have been playing all along.
+ *
+ * Sources with more than one buffer queued are streaming and never lose
+ * their voice since the application keeps feeding them.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <float.h>
+#include <math.h>
+
+#include <aax/aax.h>
+#include <AL/al.h>
+
+#include <base/types.h>
+
+#include "api.h"
+
+#define _OAL_VOICE_UPDATE_SEC		0.02
+
+static unsigned int _oalVoicesReclaim(_oalContext *);
+static void _oalVoiceVirtualize(_oalContext *, _oalSource *, double);
+static float _oalVoiceAudibility(const _oalSource *, const _oalListener *);
+static double _oalVoiceDuration(const _oalSource *);
+static int _oalVoiceCompare(const void *, const void *);
+
+static double
+_oalVoiceTime(void)
+{
+    return 1e-9*(double)nsecTime();
+}
+
+/*
+ * Register the emitter of the source at the mixer. A virtual source
+ * continues where it would have been by now. Returns zero if no voice
+ * was available.
+ */
+int
+_oalVoiceAcquire(void *context, _oalSource *src)
+{
+    _oalContext *ctx = (_oalContext*)context;
+    const _oalDevice *dev = ctx->parent_device;
+    aaxConfig config = dev->lst.handle;
+    int rv = 0;
+
+    if (ctx->num_voices >= ctx->max_voices) {
+        _oalVoicesReclaim(ctx);
+    }
+
+    if (ctx->num_voices < ctx->max_voices)
+    {
+        rv = aaxMixerRegisterEmitter(config, src->handle);
+        if (!rv && _oalVoicesReclaim(ctx)) {
+            rv = aaxMixerRegisterEmitter(config, src->handle);
+        }
+    }
+
+    if (rv)
+    {
+        src->parent = config;
+        ctx->num_voices++;
+
+        if (src->virtual)
+        {
+            ALenum state = src->virtual;
+            double offs = _oalVoiceOffset(src);
+
+            src->virtual = 0;
+            aaxEmitterSetState(src->handle, AAX_INITIALIZED);
+            aaxEmitterSetOffsetSec(src->handle, offs);
+            if (state == AL_PLAYING) {
+                aaxEmitterSetState(src->handle, AAX_PLAYING);
+            }
+        }
+    }
+
+    return rv;
+}
+
+void
+_oalVoiceRelease(void *context, _oalSource *src)
+{
+    _oalContext *ctx = (_oalContext*)context;
+
+    if (src->parent)
+    {
+        aaxMixerDeregisterEmitter(src->parent, src->handle);
+        src->parent = NULL;
+        ctx->num_voices--;
+    }
+}
+
+/*
+ * Start playing a source without a voice from the beginning, or from the
+ * position at which it was paused.
+ */
+void
+_oalVoicePlay(_oalSource *src)
+{
+    if (src->virtual != AL_PAUSED) {
+        src->offset = 0.0;
+    }
+    src->virtual = AL_PLAYING;
+    src->start = _oalVoiceTime();
+}
+
+void
+_oalVoicePause(_oalSource *src)
+{
+    if (_oalVoiceState(src) == AL_PLAYING)
+    {
+        src->offset = _oalVoiceOffset(src);
+        src->virtual = AL_PAUSED;
+    }
+    else if (!src->virtual) {
+        aaxEmitterSetState(src->handle, AAX_SUSPENDED);
+    }
+}
+
+/*
+ * Returns AL_PLAYING or AL_PAUSED for virtual sources and zero otherwise.
+ * Virtual sources which reached the end of their buffer are stopped.
+ */
+ALenum
+_oalVoiceState(_oalSource *src)
+{
+    if (src->virtual == AL_PLAYING &&
+        !aaxEmitterGetMode(src->handle, AAX_LOOPING))
+    {
+        double offs = src->offset + (_oalVoiceTime() - src->start)*src->pitch;
+        if (offs >= _oalVoiceDuration(src))
+        {
+            src->virtual = 0;
+            src->offset = 0.0;
+            aaxEmitterSetState(src->handle, AAX_STOPPED);
+        }
+    }
+
+    return src->virtual;
+}
+
+/* The playback position in seconds of a virtual source. */
+double
+_oalVoiceOffset(const _oalSource *src)
+{
+    double offs = src->offset;
+
+    if (src->virtual == AL_PLAYING)
+    {
+        double duration = _oalVoiceDuration(src);
+
+        offs += (_oalVoiceTime() - src->start)*src->pitch;
+        if (duration <= 0.0) {
+            offs = 0.0;
+        } else if (aaxEmitterGetMode(src->handle, AAX_LOOPING)) {
+            offs = fmod(offs, duration);
+        } else {
+            offs = _MIN(offs, duration);
+        }
+    }
+
+    return offs;
+}
+
+void
+_oalVoiceSetOffset(_oalSource *src, double offs)
+{
+    src->offset = offs;
+    src->start = _oalVoiceTime();
+}
+
+/*
+ * Hand out the voices of the context to the most audible playing sources.
+ * Unless force is set nothing is done if the previous pass was less than
+ * _OAL_VOICE_UPDATE_SEC ago, which makes it cheap enough to call from the
+ * listener and source setters which change the audibility.
+ */
+void
+_oalVoicesUpdate(void *context, char force)
+{
+    _oalContext *ctx = (_oalContext*)context;
+    const _oalDevice *dev = ctx->parent_device;
+    _alBuffers *cs = ctx->sources;
+    double now = _oalVoiceTime();
+    unsigned int i, n, num, voices;
+    _oalSource **list;
+
+    if (!cs) return;
+    if (!force && (now - ctx->voices_updated) < _OAL_VOICE_UPDATE_SEC) {
+        return;
+    }
+    ctx->voices_updated = now;
+
+    _AL_LOG(LOG_DEBUG, __FUNCTION__);
+
+    _alEpochEnter();
+    num = _alBufGetMaxNumNoLock(cs, _OAL_SOURCE);
+    list = num ? malloc(num*sizeof(_oalSource*)) : NULL;
+    if (list)
+    {
+        voices = ctx->max_voices;
+        n = 0;
+        for (i=0; i<num; i++)
+        {
+            const _alBufferData *dptr = _alBufGetNoLock(cs, _OAL_SOURCE, i);
+            _oalSource *src = dptr ? _alBufGetDataPtr(dptr) : NULL;
+
+            if (!src) continue;
+
+            if (src->virtual)
+            {
+                if (_oalVoiceState(src) == AL_PLAYING) {
+                    list[n++] = src;
+                }
+            }
+            else if (src->parent)
+            {
+                enum aaxState state = aaxEmitterGetState(src->handle);
+                if (state == AAX_PLAYING) {
+                    list[n++] = src;
+                } else if (state == AAX_SUSPENDED) {
+                    if (voices) voices--;	/* paused sources keep theirs */
+                } else {
+                    _oalVoiceRelease(ctx, src);
+                }
+            }
+        }
+
+        for (i=0; i<n; i++) {
+            list[i]->audibility = _oalVoiceAudibility(list[i], &dev->lst);
+        }
+        qsort(list, n, sizeof(_oalSource*), _oalVoiceCompare);
+
+        /* first free the voices of the least audible sources */
+        for (i=voices; i<n; i++)
+        {
+            if (list[i]->parent) {
+                _oalVoiceVirtualize(ctx, list[i], now);
+            }
+        }
+
+        for (i=0; i<_MIN(voices, n); i++)
+        {
+            if (list[i]->virtual && !_oalVoiceAcquire(ctx, list[i])) {
+                break;
+            }
+        }
+        free(list);
+    }
+    _alEpochLeave();
+}
+
+/* -------------------------------------------------------------------------- */
+
+/*
+ * Emitters stay registered after their source stopped. Deregister the
+ * emitters of all sources which aren't playing or paused in one pass.
+ * Returns the number of released voices.
+ */
+static unsigned int
+_oalVoicesReclaim(_oalContext *ctx)
+{
+    _alBuffers *cs = ctx->sources;
+    unsigned int i, num, rv = 0;
+
+    _AL_LOG(LOG_DEBUG, __FUNCTION__);
+
+    _alEpochEnter();
+    num = _alBufGetMaxNumNoLock(cs, _OAL_SOURCE);
+    for (i=0; i<num; i++)
+    {
+        const _alBufferData *dptr = _alBufGetNoLock(cs, _OAL_SOURCE, i);
+        _oalSource *src = dptr ? _alBufGetDataPtr(dptr) : NULL;
+
+        if (src && src->parent)
+        {
+            enum aaxState state = aaxEmitterGetState(src->handle);
+            if ((state != AAX_PLAYING) && (state != AAX_SUSPENDED))
+            {
+                _oalVoiceRelease(ctx, src);
+                rv++;
+            }
+        }
+    }
+    _alEpochLeave();
+
+    return rv;
+}
+
+static void
+_oalVoiceVirtualize(_oalContext *ctx, _oalSource *src, double now)
+{
+    if (aaxEmitterGetNoBuffers(src->handle, AAX_PLAYING) > 1) return;
+
+    src->offset = aaxEmitterGetOffsetSec(src->handle);
+    src->start = now;
+    src->virtual = AL_PLAYING;
+
+    aaxEmitterSetState(src->handle, AAX_STOPPED);
+    _oalVoiceRelease(ctx, src);
+}
+
+/*
+ * The ranking assumes the inverse distance clamped model, the default
+ * distance model, regardless of the model in use. Streaming sources
+ * always rank first.
+ */
+static float
+_oalVoiceAudibility(const _oalSource *src, const _oalListener *lst)
+{
+    float rv = src->gain*src->priority;
+
+    if (aaxEmitterGetNoBuffers(src->handle, AAX_PLAYING) > 1) {
+        rv = FLT_MAX;
+    }
+    else if (src->ref_distance > 0.0f)
+    {
+        double dx = src->pos[0], dy = src->pos[1], dz = src->pos[2];
+        float dist, ref = src->ref_distance;
+
+        if (src->mode != AAX_RELATIVE)
+        {
+            dx -= lst->pos[0];
+            dy -= lst->pos[1];
+            dz -= lst->pos[2];
+        }
+        dist = (float)sqrt(dx*dx + dy*dy + dz*dz);
+        dist = _MINMAX(dist, ref, _MAX(src->max_distance, ref));
+        rv *= ref/(ref + src->rolloff*(dist - ref));
+    }
+
+    return rv;
+}
+
+static double
+_oalVoiceDuration(const _oalSource *src)
+{
+    aaxBuffer buf = aaxEmitterGetBufferByPos(src->handle, 0, AAX_FALSE);
+    double rv = 0.0;
+
+    if (buf)
+    {
+        unsigned int freq = aaxBufferGetSetup(buf, AAX_FREQUENCY);
+        if (freq) {
+            rv = (double)aaxBufferGetSetup(buf, AAX_NO_SAMPLES)/freq;
+        }
+    }
+
+    return rv;
+}
+
+/* most audible first */
+static int
+_oalVoiceCompare(const void *a, const void *b)
+{
+    const _oalSource *s1 = *(const _oalSource**)a;
+    const _oalSource *s2 = *(const _oalSource**)b;
+
+    if (s1->audibility > s2->audibility) return -1;
+    if (s1->audibility < s2->audibility) return 1;
+    return 0;
+}
@@ -22,7 +22,6 @@
 #include "config.h"
 #endif
 
-#ifndef NDEBUG
 #include "api.h"
 
 const char *_al_id_s[_OAL_MAX_ID] =
@@ -39,5 +38,4 @@ const char *_al_id_s[_OAL_MAX_ID] =
     "_OAL_LISTENER",
     "_OAL_SBUFFER"
 };
-#endif
 
@@ -95,15 +95,35 @@ ALenum __oalStateSetErrorNormal(ALenum);
 # define _oalStateSetError(a)    __oalStateSetErrorNormal(a)
 #endif
 
+/*
+ * Updates which are held back while the context is suspended, see
+ * alcSuspendContext. They are sent to AeonWave by alcProcessContext.
+ */
+#define _OAL_DIRTY_MATRIX	0x01
+#define _OAL_DIRTY_VELOCITY	0x02
+#define _OAL_DIRTY_PITCH	0x08
+#define _OAL_DIRTY_FILTER(a)	(0x10 << (a))
+
+/*
+ * Filters of a source which are kept for the lifetime of the source so
+ * setters only have to change a parameter and push the filter. With the
+ * command queue enabled only its worker thread touches them.
+ */
+#define _OAL_FILTER_VOLUME	0
+#define _OAL_FILTER_DISTANCE	1
+#define _OAL_FILTER_DIRECTIONAL	2
+#define _OAL_FILTER_FREQUENCY	3
+#define _OAL_FILTER_MAX		4
+
 /* --- Listener --- */
-#define _MAX_THREADS		4
-#define _SRC_PER_THREAD		16
 
 typedef struct
 {
     aaxConfig handle;
     aaxVec3f at, up;
     aaxVec3d pos;
+    aaxVec3f vel;
+    unsigned int dirty;
     void *buf;
 
     struct
@@ -117,31 +137,96 @@ typedef struct
 
 /* --- Source -- */
 
+/*
+ * Source attributes which were changed from their defaults. Emitters of
+ * deleted sources are only recycled by the emitter pool if everything
+ * which was changed can be reset cheaply.
+ */
+#define _OAL_RESET_MATRIX	0x01
+#define _OAL_RESET_VELOCITY	0x02
+#define _OAL_RESET_VOLUME	0x04
+#define _OAL_RESET_PITCH	0x08
+#define _OAL_RESET_MODE		0x10
+#define _OAL_RESET_NONE		0x80	/* can't be reset, don't recycle */
+
 typedef struct
 {
     void *parent;
+    void *context;
     aaxEmitter handle;
     aaxVec3f at, up;
     aaxVec3d pos;
+    aaxVec3f vel;
+    float gain, pitch;
+    unsigned int dirty;
+    unsigned int modified;
     int mode;
+
+    /* shadow copy of the attributes, getters don't query the emitter */
+    float min_gain, max_gain;
+    float cone_inner, cone_outer, cone_outer_gain;
+    char looping;
+
+    aaxFilter filter[_OAL_FILTER_MAX];	/* created on first use */
+    aaxEffect pitch_effect;
+
+    /*
+     * The shadow copy is written by the application thread only. With the
+     * command queue enabled the worker thread keeps its own copy of the
+     * vectors it sends to the emitter.
+     */
+    aaxVec3d queued_pos;
+    aaxVec3f queued_at, queued_vel;
+
+    /* voice management, see alVoice.c */
+    float priority;
+    float audibility;
+    float ref_distance, rolloff, max_distance;	/* shadowed as well */
+    ALenum virtual;		/* AL_PLAYING or AL_PAUSED without a voice */
+    double offset;		/* playback position when virtualized	   */
+    double start;		/* time at which offset was taken	   */
 } _oalSource;
 
 void _oalFreeSource(void *, void*);
+void _oalDestroySource(void*);
+void _oalUpdateSources(void *);
+void _oalUpdateListener(_oalListener *);
+void _oalSourceCommand(void *, ALuint, ALenum, const float *);
+unsigned int _oalEmitterPoolCreate(void *, unsigned int);
+void _oalEmitterPoolDestroy(void *);
+
+/* --- Asynchronous command queue --- */
+
+typedef struct _oalCommandQueue_s _oalCommandQueue;
+
+_oalCommandQueue *_oalCommandQueueCreate(void *, char);
+void _oalCommandQueueDestroy(_oalCommandQueue *);
+void _oalCommandQueuePush(_oalCommandQueue *, ALuint, ALenum, float, float, float);
+void _oalCommandQueueSuspend(_oalCommandQueue *, char);
+void _oalCommandQueueFlush(_oalCommandQueue *);
+
+/* --- Voice management --- */
+
+int _oalVoiceAcquire(void *, _oalSource *);
+void _oalVoiceRelease(void *, _oalSource *);
+void _oalVoicePlay(_oalSource *);
+void _oalVoicePause(_oalSource *);
+ALenum _oalVoiceState(_oalSource *);
+double _oalVoiceOffset(const _oalSource *);
+void _oalVoiceSetOffset(_oalSource *, double);
+void _oalVoicesUpdate(void *, char);
 
 /* -- Contexts --- */
 
 /*
- * Device pointers returned to the caller aren't really pointers at all
- * but device-id's that reference the particular pointer in the device
- * pointer-array.
- *
- * The top bits contain the id of the device, the bottom bits the id of the
- * associated context.
+ * Device and context pointers returned to the caller aren't really pointers
+ * at all but generational handles (see BUFFER_HANDLES) of the device and
+ * the context pointer-arrays. A handle resolves to it's object with a single
+ * indexed load and handles of closed devices or destroyed contexts are
+ * detected as stale. Zero is never a valid handle.
  */
-#define _oalDeviceToId(a)	(int32_t)((size_t)(a) >> 20)
-#define _oalIdToDevice(a)	(uint32_t)((size_t)(a) << 20)
-#define _oalContextMask(a)	(uint32_t)((size_t)(a) & 0x000FFFFF)
-#define _oalDeviceMask(a)	(uint32_t)((size_t)(a) & 0xFFF00000)
+#define _oalDeviceToId(a)	(unsigned int)(size_t)(a)
+#define _oalContextToId(a)	(unsigned int)(size_t)(a)
 #define INT_TO_PTR(a)		(void*)(size_t)(a)
 
 typedef struct
@@ -152,14 +237,45 @@ typedef struct
     /* dynamic data */
     ALCboolean suspend;
     ALCenum error;
+    unsigned int dirty;		/* no. sources with held back updates */
+    _oalCommandQueue *queue;	/* NULL unless commands are asynchronous */
+
+    /* ALC_AAX_context_hints as requested by the application */
+    unsigned int mixer_threads;
+    unsigned int period_size;
+    unsigned int source_prealloc;
+    unsigned int buffer_prealloc;
+
+    /* configured emitters ready for alGenSources */
+    aaxEmitter *emitters;
+    unsigned int num_emitters;
+    unsigned int max_emitters;
+    unsigned int emitters_lock;
+
+    /* emitters registered at the mixer, see alVoice.c */
+    unsigned int max_voices;
+    unsigned int num_voices;
+    double voices_updated;
 
     _oalState *state;
     const void *parent_device;
+    unsigned int device;	/* handle of the parent device */
+    void *dptr_dev;		/* keeps the parent device alive */
 
     _alBuffers *sources;
+    _alSlab *slab;		/* _oalSource objects */
 
 } _oalContext;
 
+/*
+ * Devices opened by alcOpenDeviceAsyncAAX are added to the device array
+ * right away and get their driver from a separate thread. Device lookups
+ * wait until the driver is opened.
+ */
+#define _OAL_DEVICE_READY	0
+#define _OAL_DEVICE_OPENING	1
+#define _OAL_DEVICE_FAILED	2
+
 typedef struct
 {
     ALCboolean sync;
@@ -170,18 +286,25 @@ typedef struct
     _alBuffers *buffers;
 
     /* dynamic data */
-    unsigned int current_context;
+    unsigned int current_context; /* context handle, zero if none */
+    unsigned int state;		/* _OAL_DEVICE_READY unless opened async */
+    char *name;			/* requested name of an async device	 */
 
     _oalListener lst;
-    _alBuffers *contexts;
 
 } _oalDevice;
 
 _alBufferData *_oalGetCurrentDevice();
 _alBufferData *_oalGetCurrentContext();
 _oalDevice *_oalFindDeviceById(unsigned int);
+_alBufferData *_oalGetDeviceById(unsigned int);
+_alBufferData *_oalFindContextById(unsigned int);
+unsigned int _oalDeviceAdd(_oalDevice *);
+void _oalLockDevices();
+void _oalUnlockDevices();
 
 extern _alBuffers *_oalDevices;
+extern _alBuffers *_oalContexts;
 
 /**
  * Context Error reporting
@@ -196,6 +319,8 @@ ALCenum __oalContextSetErrorReport(ALCenum, char *, int);
 
 /* --- Buffers --- */
 
+#define _OAL_MAX_ATTRIBUTES	23	/* ALC_ALL_ATTRIBUTES incl. the zero */
+
 _alBuffers *_oalGetBuffers(_oalDevice *d);
 _alBufferData *_oalFindBufferById(ALuint, ALuint*);
 void _oalFreeBuffer(void*);
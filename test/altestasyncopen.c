@@ -0,0 +1,100 @@
+/* -*- mode: C; tab-width:8; c-basic-offset:8 -*-
+ * vi:set ts=8:
+ *
+ * This file is in the Public Domain and comes with no warranty.
+ * Erik Hofman <erik@ehofman.com>
+ *
+ */
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+
+#ifdef __APPLE__
+# include <OpenAL/al.h>
+# include <OpenAL/alc.h>
+#else
+# include <AL/al.h>
+# include <AL/alc.h>
+# include <AL/alcext.h>
+#endif
+
+#include <base/types.h>
+#include "driver.h"
+
+static double
+elapsed(double start)
+{
+   return ((double)nsecTime() - start)*1e-9;
+}
+
+int main(int argc, char **argv)
+{
+   PFNALCOPENDEVICEASYNCAAXPROC openDeviceAsync = NULL;
+   ALCdevice *device = NULL;
+   ALCcontext *context = NULL;
+   const ALCchar *s;
+   ALCint state;
+   char *devname;
+   double t;
+   int polls;
+
+   devname = getDeviceName(argc, argv);
+
+   t = (double)nsecTime();
+   s = alcGetString(NULL, ALC_DEFAULT_DEVICE_SPECIFIER);
+   printf("default device:\t\t%8.3f ms (%s)\n", 1e3*elapsed(t), s);
+
+   t = (double)nsecTime();
+   s = alcGetString(NULL, ALC_DEFAULT_DEVICE_SPECIFIER);
+   printf("default device again:\t%8.3f ms\n", 1e3*elapsed(t));
+
+   t = (double)nsecTime();
+   alcGetString(NULL, ALC_ALL_DEVICES_SPECIFIER);
+   printf("all devices:\t\t%8.3f ms\n", 1e3*elapsed(t));
+
+   if (alcIsExtensionPresent(NULL, "ALC_AAX_async_open"))
+   {
+      openDeviceAsync = (PFNALCOPENDEVICEASYNCAAXPROC)
+                       alcGetProcAddress(NULL, "alcOpenDeviceAsyncAAX");
+   }
+   if (!openDeviceAsync)
+   {
+      printf("ALC_AAX_async_open is not supported.\n");
+      return -1;
+   }
+
+   t = (double)nsecTime();
+   device = openDeviceAsync(devname);
+   printf("alcOpenDeviceAsyncAAX:\t%8.3f ms\n", 1e3*elapsed(t));
+   testForError(device, "Unable to open the audio device.");
+
+   polls = 0;
+   do
+   {
+      alcGetIntegerv(device, ALC_DEVICE_STATE_AAX, 1, &state);
+      if (state != ALC_DEVICE_OPENING_AAX) break;
+      msecSleep(1);
+   }
+   while (++polls);
+   printf("device ready after:\t%8.3f ms (%i polls)\n", 1e3*elapsed(t), polls);
+   if (state != ALC_DEVICE_READY_AAX)
+   {
+      printf("Unable to open the audio device.\n");
+      alcCloseDevice(device);
+      return -1;
+   }
+
+   context = alcCreateContext(device, NULL);
+   testForError(context, "Unable to create a valid context.");
+
+   alcMakeContextCurrent(context);
+   testForALCError(device);
+
+   alcMakeContextCurrent(NULL);
+   alcDestroyContext(context);
+   alcCloseDevice(device);
+
+   return 0;
+}
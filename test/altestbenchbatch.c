@@ -0,0 +1,125 @@
+/* -*- mode: C; tab-width:8; c-basic-offset:8 -*-
+ * vi:set ts=8:
+ *
+ * This file is in the Public Domain and comes with no warranty.
+ * Erik Hofman <erik@ehofman.com>
+ *
+ */
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef __APPLE__
+# include <OpenAL/al.h>
+# include <OpenAL/alc.h>
+#else
+# include <AL/al.h>
+# include <AL/alc.h>
+# include <AL/alext.h>
+#endif
+
+#include <base/types.h>
+#include "driver.h"
+
+#define NUM_SOURCES		400
+#define NUM_FRAMES		1000
+
+static double
+elapsed(double start)
+{
+   return ((double)nsecTime() - start)*1e-9;
+}
+
+static void
+result(const char *name, double dt)
+{
+   printf("%s:\t%8.3f ms (%6.1f us/frame)\n", name, 1e3*dt, 1e6*dt/NUM_FRAMES);
+}
+
+int main(int argc, char **argv)
+{
+   PFNALSOURCEFVBATCHAAXPROC sourcefvBatch = NULL;
+   ALCdevice *device = NULL;
+   ALCcontext *context = NULL;
+   ALuint *source;
+   ALfloat *pos, *vel;
+   char *devname;
+   double t;
+   int i, f;
+
+   devname = getDeviceName(argc, argv);
+
+   device = alcOpenDevice(devname);
+   testForError(device, "No default audio device available.");
+
+   context = alcCreateContext(device, NULL);
+   testForError(context, "Unable to create a valid context.");
+
+   alcMakeContextCurrent(context);
+   testForALCError(device);
+
+   source = malloc(NUM_SOURCES*sizeof(ALuint));
+   pos = malloc(3*NUM_SOURCES*sizeof(ALfloat));
+   vel = malloc(3*NUM_SOURCES*sizeof(ALfloat));
+   if (!source || !pos || !vel)
+   {
+      printf("Out of memory.\n");
+      return -1;
+   }
+
+   alGenSources(NUM_SOURCES, source);
+   testForALError();
+
+   for (i=0; i<3*NUM_SOURCES; i++)
+   {
+      pos[i] = (float)(i % 100);
+      vel[i] = (float)(i % 10)*0.1f;
+   }
+
+   t = (double)nsecTime();
+   for (f=0; f<NUM_FRAMES; f++)
+   {
+      for (i=0; i<NUM_SOURCES; i++)
+      {
+         alSourcefv(source[i], AL_POSITION, pos+3*i);
+         alSourcefv(source[i], AL_VELOCITY, vel+3*i);
+      }
+   }
+   result("alSourcefv per source", elapsed(t));
+   testForALError();
+
+   if (alIsExtensionPresent((const ALchar*)"AL_AAX_source_batch"))
+   {
+      sourcefvBatch = (PFNALSOURCEFVBATCHAAXPROC)
+                     alGetProcAddress((const ALchar*)"alSourcefvBatchAAX");
+   }
+
+   if (sourcefvBatch)
+   {
+      t = (double)nsecTime();
+      for (f=0; f<NUM_FRAMES; f++)
+      {
+         sourcefvBatch(NUM_SOURCES, source, AL_POSITION, pos);
+         sourcefvBatch(NUM_SOURCES, source, AL_VELOCITY, vel);
+      }
+      result("alSourcefvBatchAAX\t", elapsed(t));
+      testForALError();
+   }
+   else {
+      printf("AL_AAX_source_batch is not supported.\n");
+   }
+
+   alDeleteSources(NUM_SOURCES, source);
+   free(source);
+   free(pos);
+   free(vel);
+
+   alcMakeContextCurrent(NULL);
+   alcDestroyContext(context);
+   alcCloseDevice(device);
+
+   return 0;
+}
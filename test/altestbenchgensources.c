@@ -0,0 +1,87 @@
+/* -*- mode: C; tab-width:8; c-basic-offset:8 -*-
+ * vi:set ts=8:
+ *
+ * This file is in the Public Domain and comes with no warranty.
+ * Erik Hofman <erik@ehofman.com>
+ *
+ */
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef __APPLE__
+# include <OpenAL/al.h>
+# include <OpenAL/alc.h>
+#else
+# include <AL/al.h>
+# include <AL/alc.h>
+# include <AL/alext.h>
+#endif
+
+#include <base/types.h>
+#include "driver.h"
+
+#define NUM_SOURCES		32
+#define NUM_LOOPS		1000
+
+/* spawn and delete a burst of one-shot sources, like gunfire does */
+static void
+bench(ALCdevice *device, const char *name, const ALCint *attribs)
+{
+   ALuint source[NUM_SOURCES];
+   ALCcontext *context;
+   unsigned int i, s;
+   double dt;
+
+   context = alcCreateContext(device, attribs);
+   testForError(context, "Unable to create a valid context.");
+
+   alcMakeContextCurrent(context);
+   testForALCError(device);
+
+   dt = (double)nsecTime();
+   for (i=0; i<NUM_LOOPS; i++)
+   {
+      alGenSources(NUM_SOURCES, source);
+      for (s=0; s<NUM_SOURCES; s++)
+      {
+         alSource3f(source[s], AL_POSITION, (float)s, 0.0f, -1.0f);
+         alSourcef(source[s], AL_GAIN, 0.5f);
+      }
+      alDeleteSources(NUM_SOURCES, source);
+   }
+   dt = ((double)nsecTime() - dt)*1e-9;
+   testForALError();
+
+   printf("%i x %i sources, %s:\t%8.3f sec (%6.1f us/source)\n",
+           NUM_LOOPS, NUM_SOURCES, name, dt, 1e6*dt/(NUM_LOOPS*NUM_SOURCES));
+
+   alcMakeContextCurrent(NULL);
+   alcDestroyContext(context);
+}
+
+int main(int argc, char **argv)
+{
+   ALCdevice *device = NULL;
+   char *devname;
+
+   devname = getDeviceName(argc, argv);
+
+   device = alcOpenDevice(devname);
+   testForError(device, "No default audio device available.");
+
+   bench(device, "no pool", NULL);
+
+   if (alcIsExtensionPresent(device, "ALC_AAX_context_hints"))
+   {
+      ALCint attribs[] = { ALC_SOURCE_PREALLOC_AAX, NUM_SOURCES, 0 };
+      bench(device, "emitter pool", attribs);
+   }
+
+   alcCloseDevice(device);
+
+   return 0;
+}
@@ -0,0 +1,99 @@
+/* -*- mode: C; tab-width:8; c-basic-offset:8 -*-
+ * vi:set ts=8:
+ *
+ * This file is in the Public Domain and comes with no warranty.
+ * Erik Hofman <erik@ehofman.com>
+ *
+ */
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef __APPLE__
+# include <OpenAL/al.h>
+# include <OpenAL/alc.h>
+#else
+# include <AL/al.h>
+# include <AL/alc.h>
+#endif
+
+#include <base/types.h>
+#include "driver.h"
+
+#define NUM_SOURCES		10000
+
+static double
+elapsed(double start)
+{
+   return ((double)nsecTime() - start)*1e-9;
+}
+
+int main(int argc, char **argv)
+{
+   ALCdevice *device = NULL;
+   ALCcontext *context = NULL;
+   ALuint *source;
+   char *devname;
+   double t, dt;
+   ALint mono;
+   int i;
+
+   devname = getDeviceName(argc, argv);
+
+   device = alcOpenDevice(devname);
+   testForError(device, "No default audio device available.");
+
+   context = alcCreateContext(device, NULL);
+   testForError(context, "Unable to create a valid context.");
+
+   alcMakeContextCurrent(context);
+   testForALCError(device);
+
+   alcGetIntegerv(device, ALC_MONO_SOURCES, 1, &mono);
+   printf("mixer mono sources:\t%i\n", mono);
+
+   source = malloc(NUM_SOURCES*sizeof(ALuint));
+   testForError(source, "Out of memory.");
+
+   t = (double)nsecTime();
+   alGenSources(NUM_SOURCES, source);
+   dt = elapsed(t);
+   testForALError();
+   printf("alGenSources(%i):\t%8.3f ms\n", NUM_SOURCES, 1e3*dt);
+
+   t = (double)nsecTime();
+   for (i=0; i<NUM_SOURCES; i++)
+   {
+      float f = (float)i/NUM_SOURCES;
+      alSource3f(source[i], AL_POSITION, f, 0.0f, -f);
+      alSourcef(source[i], AL_GAIN, f);
+   }
+   dt = elapsed(t);
+   testForALError();
+   printf("%i source updates:\t%8.3f ms\n", 2*NUM_SOURCES, 1e3*dt);
+
+   t = (double)nsecTime();
+   for (i=0; i<NUM_SOURCES; i++) {
+      if (!alIsSource(source[i])) break;
+   }
+   dt = elapsed(t);
+   printf("%i alIsSource calls:\t%8.3f ms\n", NUM_SOURCES, 1e3*dt);
+   if (i != NUM_SOURCES) printf("source %i is invalid!\n", i);
+
+   t = (double)nsecTime();
+   alDeleteSources(NUM_SOURCES, source);
+   dt = elapsed(t);
+   testForALError();
+   printf("alDeleteSources(%i):\t%8.3f ms\n", NUM_SOURCES, 1e3*dt);
+
+   free(source);
+
+   alcMakeContextCurrent(NULL);
+   alcDestroyContext(context);
+   alcCloseDevice(device);
+
+   return 0;
+}
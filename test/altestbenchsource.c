@@ -0,0 +1,98 @@
+/* -*- mode: C; tab-width:8; c-basic-offset:8 -*-
+ * vi:set ts=8:
+ *
+ * This file is in the Public Domain and comes with no warranty.
+ * Erik Hofman <erik@ehofman.com>
+ *
+ */
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef __APPLE__
+# include <OpenAL/al.h>
+# include <OpenAL/alc.h>
+#else
+# include <AL/al.h>
+# include <AL/alc.h>
+#endif
+
+#include <base/types.h>
+#include "driver.h"
+
+#define MAXCALLS		10000000
+
+static double
+elapsed(double start)
+{
+   return ((double)nsecTime() - start)*1e-9;
+}
+
+static void
+bench(const char *name, ALuint source)
+{
+   unsigned int i;
+   double t, dt;
+
+   t = (double)nsecTime();
+   for (i=0; i<MAXCALLS; i++) {
+      alSourcef(source, AL_GAIN, (float)(i & 0xFF)/256.0f);
+   }
+   dt = elapsed(t);
+   testForALError();
+
+   printf("%i alSourcef calls, %s:\t%8.3f sec (%6.1f ns/call)\n",
+           MAXCALLS, name, dt, 1e9*dt/MAXCALLS);
+}
+
+int main(int argc, char **argv)
+{
+   ALCdevice *device = NULL;
+   ALCcontext *context = NULL;
+   char *devname;
+
+   devname = getDeviceName(argc, argv);
+
+   device = alcOpenDevice(devname);
+   testForError(device, "No default audio device available.");
+
+   context = alcCreateContext(device, NULL);
+   testForError(context, "Unable to create a valid context.");
+
+   alcMakeContextCurrent(context);
+   testForALCError(device);
+
+   do {
+      PFNALCSETTHREADCONTEXTPROC setThreadContext = NULL;
+      ALuint source;
+
+      alGenSources(1, &source);
+      testForALError();
+
+      bench("current context", source);
+
+      if (alcIsExtensionPresent(device, "ALC_EXT_thread_local_context"))
+      {
+         setThreadContext = (PFNALCSETTHREADCONTEXTPROC)
+                       alcGetProcAddress(device, "alcSetThreadContext");
+      }
+      if (setThreadContext)
+      {
+         setThreadContext(context);
+         bench("thread context", source);
+         setThreadContext(NULL);
+      }
+
+      alDeleteSources(1, &source);
+   }
+   while (0);
+
+   alcMakeContextCurrent(NULL);
+   alcDestroyContext(context);
+   alcCloseDevice(device);
+
+   return 0;
+}
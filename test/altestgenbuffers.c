@@ -0,0 +1,104 @@
+/* -*- mode: C; tab-width:8; c-basic-offset:8 -*-
+ * vi:set ts=8:
+ *
+ * This file is in the Public Domain and comes with no warranty.
+ * Erik Hofman <erik@ehofman.com>
+ *
+ */
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#ifdef __APPLE__
+# include <OpenAL/al.h>
+# include <OpenAL/alc.h>
+#else
+# include <AL/al.h>
+# include <AL/alc.h>
+#endif
+
+#include <base/types.h>
+#include "driver.h"
+
+#define MAXBUF			100000
+
+static double
+elapsed(clock_t start)
+{
+   return (double)(clock() - start)/CLOCKS_PER_SEC;
+}
+
+int main(int argc, char **argv)
+{
+   ALCdevice *device = NULL;
+   ALCcontext *context = NULL;
+   char *devname;
+
+   devname = getDeviceName(argc, argv);
+
+   device = alcOpenDevice(devname);
+   testForError(device, "No default audio device available.");
+
+   context = alcCreateContext(device, NULL);
+   testForError(context, "Unable to create a valid context.");
+
+   alcMakeContextCurrent(context);
+   testForALCError(device);
+
+   do {
+      ALuint *buffers;
+      unsigned int i, j;
+      clock_t t;
+
+      buffers = malloc(MAXBUF*sizeof(ALuint));
+      testForError(buffers, "Out of memory.");
+
+      srand((unsigned)time(0));
+
+      t = clock();
+      for (i=0; i<MAXBUF; i++) {
+         alGenBuffers(1, &buffers[i]);
+      }
+      testForALError();
+      printf("generate %i buffers:\t\t%8.3f sec\n", MAXBUF, elapsed(t));
+
+      for (i=0; i<MAXBUF; i++)
+      {
+         ALuint tmp = buffers[i];
+         j = rand() % MAXBUF;
+         buffers[i] = buffers[j];
+         buffers[j] = tmp;
+      }
+
+      /* delete one buffer at a random position and generate a new one */
+      t = clock();
+      for (i=0; i<MAXBUF; i++)
+      {
+         j = rand() % MAXBUF;
+         alDeleteBuffers(1, &buffers[j]);
+         alGenBuffers(1, &buffers[j]);
+      }
+      testForALError();
+      printf("replace %i random buffers:\t%8.3f sec\n", MAXBUF, elapsed(t));
+
+      t = clock();
+      for (i=0; i<MAXBUF; i++) {
+         alDeleteBuffers(1, &buffers[i]);
+      }
+      testForALError();
+      printf("delete %i buffers randomly:\t%8.3f sec\n", MAXBUF, elapsed(t));
+
+      free(buffers);
+   }
+   while (0);
+
+   alcMakeContextCurrent(NULL);
+   alcDestroyContext(context);
+   alcCloseDevice(device);
+
+   return 0;
+}
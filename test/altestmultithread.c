@@ -0,0 +1,148 @@
+/* -*- mode: C; tab-width:8; c-basic-offset:8 -*-
+ * vi:set ts=8:
+ *
+ * This file is in the Public Domain and comes with no warranty.
+ * Erik Hofman <erik@ehofman.com>
+ *
+ */
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#if HAVE_PTHREAD_H
+# include <pthread.h>
+#endif
+
+#ifdef __APPLE__
+# include <OpenAL/al.h>
+# include <OpenAL/alc.h>
+#else
+# include <AL/al.h>
+# include <AL/alc.h>
+# include <AL/alext.h>
+#endif
+
+#include <base/types.h>
+#include "driver.h"
+
+#define DEVICE2			"AeonWave Loopback"
+#define MAX_THREADS		8
+#define NUM_SOURCES		16
+#define NUM_LOOPS		100000
+
+typedef struct
+{
+   const char *devname;
+   unsigned int id;
+   int errors;
+} _thread_t;
+
+static PFNALCSETTHREADCONTEXTPROC setThreadContext = NULL;
+
+static void *
+thread_run(void *arg)
+{
+   _thread_t *t = arg;
+   ALCdevice *device;
+   ALCcontext *context;
+
+   /* every other thread uses the secondary device */
+   device = alcOpenDevice((t->id & 1) ? DEVICE2 : t->devname);
+   if (!device)
+   {
+      printf("thread %i: unable to open the device.\n", t->id);
+      t->errors++;
+      return NULL;
+   }
+
+   context = alcCreateContext(device, NULL);
+   if (context && setThreadContext(context))
+   {
+      ALuint source[NUM_SOURCES];
+      unsigned int i, s;
+
+      alGenSources(NUM_SOURCES, source);
+      for (i=0; i<NUM_LOOPS; i++)
+      {
+         float f = (float)(i & 0xFF)/256.0f;
+
+         s = i % NUM_SOURCES;
+         alSourcef(source[s], AL_GAIN, f);
+         alSource3f(source[s], AL_POSITION, f, -f, 0.0f);
+      }
+      if (alGetError() != AL_NO_ERROR) t->errors++;
+
+      alDeleteSources(NUM_SOURCES, source);
+      setThreadContext(NULL);
+   }
+   else
+   {
+      printf("thread %i: unable to create a valid context.\n", t->id);
+      t->errors++;
+   }
+
+   alcDestroyContext(context);
+   alcCloseDevice(device);
+
+   return NULL;
+}
+
+int main(int argc, char **argv)
+{
+#if HAVE_PTHREAD_H
+   pthread_t thread[MAX_THREADS];
+   _thread_t data[MAX_THREADS];
+   ALCdevice *device;
+   unsigned int i, num;
+   int errors = 0;
+   char *devname;
+   double dt;
+
+   devname = getDeviceName(argc, argv);
+
+   /* keep one device open to query the extension */
+   device = alcOpenDevice(devname);
+   testForError(device, "No default audio device available.");
+
+   if (alcIsExtensionPresent(device, "ALC_EXT_thread_local_context"))
+   {
+      setThreadContext = (PFNALCSETTHREADCONTEXTPROC)
+                    alcGetProcAddress(device, "alcSetThreadContext");
+   }
+   testForError(setThreadContext, "ALC_EXT_thread_local_context not supported.");
+
+   num = MAX_THREADS;
+   if (argc > 1 && atoi(argv[argc-1]) > 0) {
+      num = _MIN(atoi(argv[argc-1]), MAX_THREADS);
+   }
+
+   dt = (double)nsecTime();
+   for (i=0; i<num; i++)
+   {
+      data[i].devname = devname;
+      data[i].id = i;
+      data[i].errors = 0;
+      pthread_create(&thread[i], NULL, thread_run, &data[i]);
+   }
+
+   for (i=0; i<num; i++)
+   {
+      pthread_join(thread[i], NULL);
+      errors += data[i].errors;
+   }
+   dt = ((double)nsecTime() - dt)*1e-9;
+
+   printf("%i threads, %i source updates each:\t%8.3f sec\n",
+           num, 2*NUM_LOOPS, dt);
+   if (errors) printf("%i errors detected.\n", errors);
+
+   alcCloseDevice(device);
+
+   return errors ? -1 : 0;
+#else
+   printf("Multi-threading is not supported on this platform.\n");
+   return 0;
+#endif
+}
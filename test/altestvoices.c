@@ -0,0 +1,140 @@
+/* -*- mode: C; tab-width:8; c-basic-offset:8 -*-
+ * vi:set ts=8:
+ *
+ * This file is in the Public Domain and comes with no warranty.
+ * Erik Hofman <erik@ehofman.com>
+ *
+ */
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#ifdef __APPLE__
+# include <OpenAL/al.h>
+# include <OpenAL/alc.h>
+#else
+# include <AL/al.h>
+# include <AL/alc.h>
+# include <AL/alext.h>
+# include <AL/alcext.h>
+#endif
+
+#include <base/types.h>
+#include <base/geometry.h>
+#include "driver.h"
+#include "wavfile.h"
+
+#define NUM_SOURCES		32
+#define NUM_VOICES		4
+#define FILE_PATH		SRC_PATH"/wasp.wav"
+
+ALfloat ListenerPos[] = { 0.0, 0.0, 0.0 };
+ALfloat ListenerOri[] = { 0.0f, 0.0f, -1.0f,  0.0f, 1.0f, 0.0f };
+
+int main(int argc, char **argv)
+{
+   ALCint attribs[] = { ALC_MAX_VOICES_AAX, NUM_VOICES, 0 };
+   ALCdevice *device = NULL;
+   ALCcontext *context = NULL;
+   char *devname, *infile;
+
+   infile = getInputFile(argc, argv, FILE_PATH);
+   devname = getDeviceName(argc, argv);
+
+   device = alcOpenDevice(devname);
+   testForError(device, "No default audio device available.");
+
+   context = alcCreateContext(device, attribs);
+   testForError(context, "Unable to create a valid context.");
+
+   alcMakeContextCurrent(context);
+   testForALCError(device);
+
+   do {
+      unsigned int no_samples, fmt;
+      char bps, channels;
+      void *data;
+      int freq;
+
+      data = fileLoad(infile, &no_samples, &freq, &bps, &channels, &fmt);
+      testForError(data, "Input file not found.\n");
+
+      if (data)
+      {
+         ALuint buffer, source[NUM_SOURCES];
+         ALint state, playing;
+         ALenum format;
+         ALfloat offs;
+         int i, j;
+
+         if      ((bps == 8) && (channels == 1)) format = AL_FORMAT_MONO8;
+         else if ((bps == 16) && (channels == 1)) format = AL_FORMAT_MONO16;
+         else break;
+
+         alGenBuffers(1, &buffer);
+         alBufferData(buffer, format, data, no_samples*bps/8, freq);
+         free(data);
+         testForALError();
+
+         alListenerfv(AL_POSITION, ListenerPos);
+         alListenerfv(AL_ORIENTATION, ListenerOri);
+
+         alGenSources(NUM_SOURCES, source);
+         testForALError();
+
+         /* only the NUM_VOICES sources nearest to the listener are heard */
+         for (i=0; i<NUM_SOURCES; i++)
+         {
+            float ang = 2.0f*GMATH_PI*i/NUM_SOURCES;
+            float r = 2.0f + 3.0f*i;
+
+            alSourcei(source[i], AL_BUFFER, buffer);
+            alSourcei(source[i], AL_LOOPING, AL_TRUE);
+            alSource3f(source[i], AL_POSITION, r*sinf(ang), 0.0f, -r*cosf(ang));
+         }
+
+         /* except for the farthest one which is more important */
+         if (alIsExtensionPresent((const ALchar*)"AL_AAX_source_priority")) {
+            alSourcef(source[NUM_SOURCES-1], AL_SOURCE_PRIORITY_AAX, 1000.0f);
+         }
+         testForALError();
+
+         alSourcePlayv(NUM_SOURCES, source);
+         testForALError();
+
+         /* the listener walks away from the nearest sources */
+         for (j=0; j<30; j++)
+         {
+            ListenerPos[2] -= 2.0f;
+            alListenerfv(AL_POSITION, ListenerPos);
+            msecSleep(100);
+         }
+
+         playing = 0;
+         for (i=0; i<NUM_SOURCES; i++)
+         {
+            alGetSourcei(source[i], AL_SOURCE_STATE, &state);
+            if (state == AL_PLAYING) playing++;
+         }
+         alGetSourcef(source[0], AL_SEC_OFFSET, &offs);
+         printf("%i of %i sources playing using %i voices\n",
+                 playing, NUM_SOURCES, NUM_VOICES);
+         printf("source 0 offset: %5.2f sec\n", offs);
+
+         alSourceStopv(NUM_SOURCES, source);
+         alDeleteSources(NUM_SOURCES, source);
+         alDeleteBuffers(1, &buffer);
+      }
+   }
+   while (0);
+
+   alcMakeContextCurrent(NULL);
+   alcDestroyContext(context);
+   alcCloseDevice(device);
+
+   return 0;
+}